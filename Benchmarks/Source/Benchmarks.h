@@ -0,0 +1,16 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+/*the numbers the plugin's comments promise, measured, each benchmark prints what it measured next to what it's held
+to and returns false if it didn't make it
+
+run them all with no arguments, or name the ones to run, only the Release configuration's numbers mean anything*/
+namespace Benchmarks
+{
+    //ns per frame of LoudnessMeter, both sides, for every DspKernels version this cpu can run
+    bool runLoudness();
+
+    //ms to build a hundred processors the way a scan does, then one from nothing to its first block, reported only
+    bool runStartup();
+}
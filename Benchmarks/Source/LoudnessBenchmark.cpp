@@ -0,0 +1,86 @@
+#include "Benchmarks.h"
+#include "../../Source/LoudnessMeter.h"
+
+namespace
+{
+    //what the LoudnessMeter header says it costs
+    const double budgetNsPerFrame = 10.0;
+
+    const double sampleRate = 48000.0;
+    const int blockSize     = 512;
+
+    //long enough that the timer's resolution and the odd interrupt don't show
+    const int numBlocks     = 20000;
+
+    //the meter on its own for numBlocks, input and output both, in ns per frame
+    double measureLoudness(const juce::AudioBuffer<float>& input, const juce::AudioBuffer<float>& output)
+    {
+        LoudnessMeter meter;
+        meter.prepare(sampleRate, blockSize);
+
+        //the first blocks fill the caches and get the clock up
+        for (int block = 0; block < numBlocks / 10; ++block)
+        {
+            meter.pushInput(input);
+            meter.pushOutput(output);
+        }
+
+        auto start = juce::Time::getHighResolutionTicks();
+
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            meter.pushInput(input);
+            meter.pushOutput(output);
+        }
+
+        auto seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+
+        //the meter has to have actually measured something, or the loop could have been thrown away
+        jassert(meter.getInputLevel() > -70.0f && meter.getOutputLevel() > -70.0f);
+
+        return seconds * 1.0e9 / ((double) numBlocks * blockSize);
+    }
+}
+
+bool Benchmarks::runLoudness()
+{
+    juce::AudioBuffer<float> input(2, blockSize), output(2, blockSize);
+    juce::Random random(1770);
+
+    for (auto* buffer : { &input, &output })
+        for (int channel = 0; channel < 2; ++channel)
+            for (int sample = 0; sample < blockSize; ++sample)
+                buffer->setSample(channel, sample, (random.nextFloat() * 2.0f - 1.0f) * 0.5f);
+
+    //the plugin runs the widest version there is, that's the one held to the budget
+    auto widest = DspKernels::Isa::baseline;
+
+    for (auto isa : { DspKernels::Isa::avx2, DspKernels::Isa::avx512 })
+        if (DspKernels::isAvailable(isa))
+            widest = isa;
+
+    bool ok = true;
+
+    for (auto isa : { DspKernels::Isa::baseline, DspKernels::Isa::avx2, DspKernels::Isa::avx512 })
+    {
+        if (! DspKernels::isAvailable(isa))
+            continue;
+
+        DspKernels::forceIsa(isa);
+        DspKernels::select();
+
+        auto nsPerFrame = measureLoudness(input, output);
+        auto inBudget = nsPerFrame <= budgetNsPerFrame;
+
+        std::cout << "loudness, " << DspKernels::getName(isa) << ": " << juce::String(nsPerFrame, 2) << " ns/frame"
+                  << " (budget " << juce::String(budgetNsPerFrame, 0) << ")" << (inBudget ? "" : " OVER") << std::endl;
+
+        if (isa == widest)
+            ok = inBudget;
+    }
+
+    DspKernels::clearForcedIsa();
+    DspKernels::select();
+
+    return ok;
+}
@@ -0,0 +1,25 @@
+#include <JuceHeader.h>
+#include "Benchmarks.h"
+
+//runs every benchmark, or just the ones named on the command line, the exit code is 1 if any missed its budget
+int main (int argc, char* argv[])
+{
+    const std::pair<const char*, bool (*)()> benchmarks[] =
+    {
+        { "loudness", Benchmarks::runLoudness },
+        { "startup",  Benchmarks::runStartup }
+    };
+
+    juce::StringArray names;
+
+    for (int i = 1; i < argc; ++i)
+        names.add(juce::String(argv[i]).toLowerCase());
+
+    bool ok = true;
+
+    for (auto& benchmark : benchmarks)
+        if (names.isEmpty() || names.contains(benchmark.first))
+            ok = benchmark.second() && ok;
+
+    return ok ? 0 : 1;
+}
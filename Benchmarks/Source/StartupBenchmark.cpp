@@ -0,0 +1,75 @@
+#include "Benchmarks.h"
+#include "../../Source/PluginProcessor.h"
+
+namespace
+{
+    const double sampleRate = 48000.0;
+    const int blockSize     = 512;
+
+    //what a session of ours opens, and what a scan does to every one of them
+    const int numInstances  = 100;
+
+    double getMilliseconds(juce::int64 start, juce::int64 end)
+    {
+        return juce::Time::highResolutionTicksToSeconds(end - start) * 1000.0;
+    }
+}
+
+bool Benchmarks::runStartup()
+{
+    //the processor's timer and async updates need a message manager, nothing here runs the loop
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    //a scan builds every instance and throws it away without ever preparing it
+    {
+        std::vector<std::unique_ptr<RealMagiVerbAudioProcessor>> instances;
+        instances.reserve((size_t) numInstances);
+
+        auto start = juce::Time::getHighResolutionTicks();
+
+        for (int i = 0; i < numInstances; ++i)
+            instances.push_back(std::make_unique<RealMagiVerbAudioProcessor>());
+
+        auto built = juce::Time::getHighResolutionTicks();
+        instances.clear();
+        auto destroyed = juce::Time::getHighResolutionTicks();
+
+        std::cout << "startup, scan: " << juce::String(getMilliseconds(start, built) / numInstances, 3)
+                  << " ms to build an instance, " << juce::String(getMilliseconds(built, destroyed) / numInstances, 3)
+                  << " ms to delete one" << std::endl;
+    }
+
+    //one instance the way a host opens it, from nothing to the first block of audio
+    auto start = juce::Time::getHighResolutionTicks();
+
+    auto processor = std::make_unique<RealMagiVerbAudioProcessor>();
+    auto built = juce::Time::getHighResolutionTicks();
+
+    processor->setPlayConfigDetails(processor->getTotalNumInputChannels(), processor->getTotalNumOutputChannels(),
+                                    sampleRate, blockSize);
+    processor->prepareToPlay(sampleRate, blockSize);
+    auto prepared = juce::Time::getHighResolutionTicks();
+
+    juce::AudioBuffer<float> buffer(juce::jmax(processor->getTotalNumInputChannels(), processor->getTotalNumOutputChannels()),
+                                    blockSize);
+    juce::Random random(45);
+
+    for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+        for (int sample = 0; sample < blockSize; ++sample)
+            buffer.setSample(channel, sample, (random.nextFloat() * 2.0f - 1.0f) * 0.5f);
+
+    juce::MidiBuffer midi;
+    processor->processBlock(buffer, midi);
+    auto firstBlock = juce::Time::getHighResolutionTicks();
+
+    std::cout << "startup, first block: " << juce::String(getMilliseconds(start, built), 3) << " ms to build, "
+              << juce::String(getMilliseconds(built, prepared), 3) << " ms to prepare, "
+              << juce::String(getMilliseconds(prepared, firstBlock), 3) << " ms for the first block, "
+              << juce::String(getMilliseconds(start, firstBlock), 3) << " ms in all, "
+              << juce::String((double) processor->getMemoryUsage() / (1024.0 * 1024.0), 2) << " MB prepared" << std::endl;
+
+    processor->releaseResources();
+
+    //nothing to hold it to yet, the numbers are there to compare changes against
+    return true;
+}
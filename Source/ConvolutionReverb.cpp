@@ -0,0 +1,381 @@
+#include "ConvolutionReverb.h"
+
+ConvolutionEngine::ConvolutionEngine(std::shared_ptr<const ImpulseSpectra> spectra, int numChannels)
+{
+    hasTail = spectra->tail.front() != nullptr;
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        auto source = (size_t) juce::jmin(channel, spectra->numChannels - 1);
+
+        auto newChannel = std::make_unique<Channel>(*this);
+        newChannel->head.prepare(spectra->head[source]);
+        newChannel->headInput.assign(headBlockSize, 0.0f);
+        newChannel->headOutput.assign(headBlockSize, 0.0f);
+
+        if (hasTail)
+        {
+            newChannel->tail.prepare(spectra->tail[source]);
+            newChannel->tailInput.assign(tailBlockSize, 0.0f);
+            newChannel->jobInput.assign(tailBlockSize, 0.0f);
+            newChannel->tailOutput[0].assign(tailBlockSize, 0.0f);
+            newChannel->tailOutput[1].assign(tailBlockSize, 0.0f);
+        }
+
+        channels.push_back(std::move(newChannel));
+    }
+
+    if (hasTail)
+        partitionGains.assign((size_t) channels.front()->tail.getNumPartitions(), 1.0f);
+}
+
+ConvolutionEngine::~ConvolutionEngine()
+{
+}
+
+void ConvolutionEngine::reset()
+{
+    finishTailJob();
+
+    for (auto& channel : channels)
+    {
+        channel->head.reset();
+        std::fill(channel->headInput.begin(), channel->headInput.end(), 0.0f);
+        std::fill(channel->headOutput.begin(), channel->headOutput.end(), 0.0f);
+
+        if (hasTail)
+        {
+            channel->tail.reset();
+            std::fill(channel->tailInput.begin(), channel->tailInput.end(), 0.0f);
+            std::fill(channel->tailOutput[0].begin(), channel->tailOutput[0].end(), 0.0f);
+            std::fill(channel->tailOutput[1].begin(), channel->tailOutput[1].end(), 0.0f);
+        }
+    }
+
+    headPosition    = 0;
+    tailPosition    = 0;
+    playSlot        = 1;
+    computeSlot     = 0;
+}
+
+bool ConvolutionEngine::process(float* const* data, int numChannels, int numSamples, float length) noexcept
+{
+    numChannels = juce::jmin(numChannels, (int) channels.size());
+
+    bool queued = false;
+    int done = 0;
+
+    while (done < numSamples)
+    {
+        //up to whichever block boundary comes first
+        auto todo = juce::jmin(numSamples - done, headBlockSize - headPosition);
+
+        if (hasTail)
+            todo = juce::jmin(todo, tailBlockSize - tailPosition);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            auto& state = *channels[(size_t) channel];
+            auto* samples = data[channel] + done;
+
+            juce::FloatVectorOperations::copy(state.headInput.data() + headPosition, samples, todo);
+            juce::FloatVectorOperations::copy(samples, state.headOutput.data() + headPosition, todo);
+
+            if (hasTail)
+            {
+                juce::FloatVectorOperations::copy(state.tailInput.data() + tailPosition, state.headInput.data() + headPosition, todo);
+                juce::FloatVectorOperations::add(samples, state.tailOutput[playSlot].data() + tailPosition, todo);
+            }
+        }
+
+        done            += todo;
+        headPosition    += todo;
+        tailPosition    += todo;
+
+        if (headPosition == headBlockSize)
+        {
+            for (int channel = 0; channel < numChannels; ++channel)
+            {
+                auto& state = *channels[(size_t) channel];
+                state.head.process(state.headInput.data(), state.headOutput.data());
+            }
+
+            headPosition = 0;
+        }
+
+        if (hasTail && tailPosition == tailBlockSize)
+        {
+            queueTailJob(numChannels, length);
+            tailPosition = 0;
+            queued = true;
+        }
+    }
+
+    return queued;
+}
+
+void ConvolutionEngine::queueTailJob(int numChannels, float length) noexcept
+{
+    //the blocks queued last time have to be ready now, they're what gets played from here on
+    finishTailJob();
+
+    playSlot    = computeSlot;
+    computeSlot = 1 - computeSlot;
+
+    for (auto& channel : channels)
+        std::swap(channel->tailInput, channel->jobInput);
+
+    //the tail stops at length and fades out over the last quarter before that, silent partitions are skipped
+    auto numPartitions  = (int) partitionGains.size();
+    auto end            = length * (float) numPartitions;
+    auto fade           = juce::jmax(1.0f, end * 0.25f);
+
+    for (int partition = 0; partition < numPartitions; ++partition)
+        partitionGains[(size_t) partition] = juce::jlimit(0.0f, 1.0f, (end - (float) partition) / fade);
+
+    numQueuedChannels = numChannels;
+
+    for (int channel = 0; channel < numQueuedChannels; ++channel)
+        channels[(size_t) channel]->tailTask.arm();
+}
+
+void ConvolutionEngine::submitTailJobs(DspThreadPool& pool) noexcept
+{
+    for (int channel = 0; channel < numQueuedChannels; ++channel)
+        pool.submit(channels[(size_t) channel]->tailTask);
+}
+
+void ConvolutionEngine::finishTailJob() noexcept
+{
+    for (int channel = 0; channel < numQueuedChannels; ++channel)
+        channels[(size_t) channel]->tailTask.waitOrRunInline();
+
+    numQueuedChannels = 0;
+}
+
+size_t ConvolutionEngine::getSizeInBytes() const noexcept
+{
+    size_t size = partitionGains.size() * sizeof(float);
+
+    for (auto& channel : channels)
+    {
+        size += channel->head.getSizeInBytes() + channel->tail.getSizeInBytes();
+        size += (channel->headInput.size() + channel->headOutput.size() + channel->tailInput.size()
+                 + channel->jobInput.size() + channel->tailOutput[0].size() + channel->tailOutput[1].size()) * sizeof(float);
+    }
+
+    return size;
+}
+
+void ConvolutionEngine::Channel::runTail(void* context)
+{
+    auto& channel = *static_cast<Channel*>(context);
+    auto& engine = channel.engine;
+
+    channel.tail.process(channel.jobInput.data(), channel.tailOutput[engine.computeSlot].data(), engine.partitionGains.data());
+}
+
+//==============================================================================
+ConvolutionReverb::ConvolutionReverb()
+{
+    dampingFilter.setType(juce::dsp::StateVariableTPTFilterType::lowpass);
+}
+
+ConvolutionReverb::~ConvolutionReverb()
+{
+    stopTimer();
+
+    //a load that finishes after this would hand its engine to a reverb that's gone
+    if (cache != nullptr)
+        cache->get().cancel(this);
+
+    //and the pool can't be left holding tail blocks of an engine that's about to be deleted
+    if (engine != nullptr)
+        engine->finishTailJob();
+}
+
+void ConvolutionReverb::prepare(const juce::dsp::ProcessSpec& spec)
+{
+    sampleRate  = spec.sampleRate;
+    numChannels = (int) spec.numChannels;
+
+    //nothing to collect before anything ran, an instance that only gets scanned never starts it
+    if (! isTimerRunning())
+        startTimer(500);
+
+    predelay.setMaximumDelayInSamples((int) std::ceil(maxPredelayMs / 1000.0 * sampleRate) + 1);
+    predelay.prepare(spec);
+
+    predelaySamples.reset(sampleRate, 0.05);
+
+    dampingFilter.prepare(spec);
+
+    //a new sample rate means the impulse has to be resampled again
+    if (sampleRate != requestedSampleRate || numChannels != requestedChannels)
+        requestEngine();
+
+    resetRequested = true;
+}
+
+void ConvolutionReverb::reset()
+{
+    //the engine belongs to the audio thread, it resets itself on the next block
+    resetRequested = true;
+}
+
+bool ConvolutionReverb::loadImpulseResponse(const juce::File& file)
+{
+    if (! file.existsAsFile())
+        return false;
+
+    {
+        const juce::ScopedLock lock(impulseLock);
+        impulseFile = file;
+    }
+
+    requestEngine();
+    return true;
+}
+
+juce::File ConvolutionReverb::getImpulseResponseFile() const
+{
+    const juce::ScopedLock lock(impulseLock);
+    return impulseFile;
+}
+
+void ConvolutionReverb::unloadImpulseResponse()
+{
+    {
+        const juce::ScopedLock lock(impulseLock);
+
+        if (impulseFile == juce::File())
+            return;
+
+        impulseFile = juce::File();
+    }
+
+    //neither a load that's still running nor an engine that hasn't been picked up yet can bring it back
+    if (cache != nullptr)
+        cache->get().cancel(this);
+    engines.set(nullptr);
+    engineBytes = 0;
+    impulseSeconds = 0.0;
+    requestedSampleRate = 0.0;
+
+    unloadRequested = true;
+}
+
+void ConvolutionReverb::requestEngine()
+{
+    auto file = getImpulseResponseFile();
+
+    if (file == juce::File())
+        return;
+
+    //an engine only ever comes from the cache, so the pool is always there by the time the audio thread has one
+    if (cache == nullptr)
+    {
+        cache   = std::make_unique<juce::SharedResourcePointer<ImpulseCache>>();
+        pool    = std::make_unique<juce::SharedResourcePointer<DspThreadPool>>();
+    }
+
+    requestedSampleRate = sampleRate;
+    requestedChannels   = numChannels;
+
+    auto channels   = numChannels;
+    auto rate       = sampleRate;
+
+    //runs on the cache's thread, building the engine there keeps its allocations off the message thread too
+    cache->get().request(file, sampleRate, this, [this, channels, rate](std::shared_ptr<const ImpulseSpectra> spectra)
+    {
+        if (spectra != nullptr)
+        {
+            impulseSeconds = spectra->numSamples / rate;
+
+            auto newEngine = std::make_unique<ConvolutionEngine>(std::move(spectra), channels);
+            engineBytes = newEngine->getSizeInBytes();
+            engines.set(std::move(newEngine));
+        }
+    });
+}
+
+void ConvolutionReverb::setParameters(float predelayMs, float newLength, float damping, bool shouldUseThreadPool) noexcept
+{
+    useThreadPool = shouldUseThreadPool;
+
+    predelaySamples.setTargetValue(juce::jlimit(0.0f, maxPredelayMs, predelayMs) / 1000.0f * (float) sampleRate);
+    length = newLength;
+
+    //all the way open at 0, 1k at 1
+    auto cutoff = 20000.0f * std::pow(0.05f, damping);
+
+    if (cutoff != dampingFilter.getCutoffFrequency())
+        dampingFilter.setCutoffFrequency(cutoff);
+}
+
+bool ConvolutionReverb::process(juce::AudioBuffer<float>& buffer) noexcept
+{
+    //the engine stays with the handoff until the next one replaces it, it just doesn't get used anymore
+    if (unloadRequested.exchange(false) && engine != nullptr)
+    {
+        engine->finishTailJob();
+        engine = nullptr;
+    }
+
+    //the old engine has to finish its tail blocks, so the pool lets go of it, before it's given back
+    if (engines.hasPending())
+    {
+        if (engine != nullptr)
+            engine->finishTailJob();
+
+        engine = engines.get();
+        resetRequested = true;
+    }
+
+    if (engine == nullptr)
+        return false;
+
+    if (resetRequested.exchange(false))
+    {
+        engine->reset();
+        predelay.reset();
+        dampingFilter.reset();
+    }
+
+    auto channels = juce::jmin(buffer.getNumChannels(), numChannels);
+    auto numSamples = buffer.getNumSamples();
+
+    for (int sample = 0; sample < numSamples; ++sample)
+    {
+        auto delay = predelaySamples.getNextValue();
+
+        for (int channel = 0; channel < channels; ++channel)
+        {
+            predelay.pushSample(channel, buffer.getSample(channel, sample));
+            buffer.setSample(channel, sample, predelay.popSample(channel, delay));
+        }
+    }
+
+    if (engine->process(buffer.getArrayOfWritePointers(), channels, numSamples, length) && useThreadPool)
+        engine->submitTailJobs(pool->get());
+
+    juce::dsp::AudioBlock<float> block(buffer.getArrayOfWritePointers(), (size_t) channels, (size_t) numSamples);
+    juce::dsp::ProcessContextReplacing<float> context(block);
+    dampingFilter.process(context);
+
+    return true;
+}
+
+size_t ConvolutionReverb::getSizeInBytes() const noexcept
+{
+    //the longest predelay and one sample over on every channel
+    auto predelayBytes = (size_t) (predelay.getMaximumDelayInSamples() + 1) * (size_t) numChannels * sizeof(float);
+
+    return engineBytes.load() + predelayBytes;
+}
+
+void ConvolutionReverb::timerCallback()
+{
+    //an engine only gets retired after its tail blocks are done, so nothing else can be holding it by now
+    engines.collectGarbage();
+}
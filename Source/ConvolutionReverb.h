@@ -0,0 +1,150 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "PartitionedConvolver.h"
+#include "ImpulseCache.h"
+#include "RealtimeHandoff.h"
+#include "DspThreadPool.h"
+
+/*two level non-uniform partitioned convolution of a few channels with an impulse response
+
+the head of the impulse response runs in small partitions right on the audio thread so the latency stays at one
+head block, the rest runs in big partitions that are cheap per sample but only come around once every tail block,
+those get handed to a background thread
+
+the tail starts two tail blocks into the (latency shifted) impulse response, so a tail block that got queued has a
+whole tail block of time to be worked out before its output is needed, every channel's tail block is its own task
+for the shared thread pool, if the pool hasn't got to one by then the audio thread just does it itself*/
+class ConvolutionEngine
+{
+public:
+    static const int headBlockSize = ImpulseSpectra::headBlockSize;
+    static const int tailBlockSize = ImpulseSpectra::tailBlockSize;
+
+    //the spectra are shared, only the input side is allocated here, still not for the audio thread
+    ConvolutionEngine(std::shared_ptr<const ImpulseSpectra> spectra, int numChannels);
+    ~ConvolutionEngine();
+
+    void reset();
+
+    //replaces the channels with the wet signal, headBlockSize samples late
+    //length (0 to 1) fades the tail out early, returns true if it queued tail blocks that can be submitted
+    bool process(float* const* channels, int numChannels, int numSamples, float length) noexcept;
+
+    //audio thread, hands the queued tail blocks to the pool, anything it doesn't take runs inline when it's due
+    void submitTailJobs(DspThreadPool& pool) noexcept;
+
+    //audio thread, makes sure the queued tail blocks are done, running them here if they have to
+    void finishTailJob() noexcept;
+
+    //the input side of every channel, what an engine costs on top of the shared spectra
+    size_t getSizeInBytes() const noexcept;
+
+private:
+    struct Channel
+    {
+        Channel(ConvolutionEngine& e) : engine(e) {}
+
+        ConvolutionEngine& engine;
+        PartitionedConvolver head, tail;
+        std::vector<float> headInput, headOutput;
+        std::vector<float> tailInput, jobInput;
+        std::vector<float> tailOutput[2];
+
+        DspTask tailTask{ runTail, this };
+        static void runTail(void* channel);
+    };
+
+    std::vector<std::unique_ptr<Channel>> channels;
+    bool hasTail = false;
+
+    int headPosition = 0;
+    int tailPosition = 0;
+
+    //the tail block being played back, and the one the job is writing
+    int playSlot    = 1;
+    int computeSlot = 0;
+
+    //per tail partition gains for the queued job, worked out from the length when it was queued
+    std::vector<float> partitionGains;
+
+    //how many channels the queued tail blocks are for
+    int numQueuedChannels = 0;
+
+    void queueTailJob(int numChannels, float length) noexcept;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ConvolutionEngine)
+};
+
+//the reverb built around the engine, loads the impulse response, hands the tail blocks to the shared thread pool
+//and does the predelay and damping around the convolution
+class ConvolutionReverb : private juce::Timer
+{
+public:
+    ConvolutionReverb();
+    ~ConvolutionReverb() override;
+
+    void prepare(const juce::dsp::ProcessSpec& spec);
+    void reset();
+
+    //message thread, gets the impulse from the shared cache (loading it there if it has to) on the cache's thread,
+    //the audio thread switches over on the first block after that
+    bool loadImpulseResponse(const juce::File& file);
+    juce::File getImpulseResponseFile() const;
+
+    //message thread, drops the impulse response, the audio thread lets go of its engine on the next block
+    void unloadImpulseResponse();
+
+    //audio thread, once per control block, damping and length are 0 to 1
+    //without the thread pool the tail blocks all run on the audio thread
+    void setParameters(float predelayMs, float length, float damping, bool useThreadPool) noexcept;
+
+    //audio thread, replaces the buffer with the wet signal
+    //returns false and leaves the buffer alone if no impulse response is loaded
+    bool process(juce::AudioBuffer<float>& buffer) noexcept;
+
+    //any thread, how long the newest engine's impulse is, 0 while there's none
+    double getImpulseLengthSeconds() const noexcept { return impulseSeconds.load(); }
+
+    //any thread, the predelay and the newest engine's input side, the impulse itself is shared and isn't counted
+    size_t getSizeInBytes() const noexcept;
+
+    static constexpr float maxPredelayMs = 100.0f;
+
+private:
+    //frees the engines the audio thread let go of
+    void timerCallback() override;
+
+    //asks the cache for the impulse at the current sample rate, the engine gets built when it arrives
+    void requestEngine();
+
+    //made with the first impulse that gets asked for, so an instance that's only scanned, or never loads one,
+    //doesn't start the cache's thread or the pool's workers
+    std::unique_ptr<juce::SharedResourcePointer<ImpulseCache>> cache;
+    std::unique_ptr<juce::SharedResourcePointer<DspThreadPool>> pool;
+
+    RealtimeHandoff<ConvolutionEngine> engines;
+    std::atomic<size_t> engineBytes{ 0 };
+    std::atomic<double> impulseSeconds{ 0.0 };
+
+    //the engine the audio thread is using
+    ConvolutionEngine* engine = nullptr;
+    std::atomic<bool> resetRequested{ false }, unloadRequested{ false };
+    bool useThreadPool = true;
+
+    //where the impulse came from, kept so a new sample rate can rebuild the engine
+    juce::CriticalSection impulseLock;
+    juce::File impulseFile;
+    double requestedSampleRate  = 0.0;
+    int requestedChannels       = 0;
+
+    double sampleRate   = 44100.0;
+    int numChannels     = 2;
+
+    juce::dsp::DelayLine<float> predelay;
+    juce::SmoothedValue<float> predelaySamples;
+    juce::dsp::StateVariableTPTFilter<float> dampingFilter;
+    float length = 1.0f;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ConvolutionReverb)
+};
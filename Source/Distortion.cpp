@@ -0,0 +1,295 @@
+#include "Distortion.h"
+#include "DspKernels.h"
+
+namespace
+{
+    //the shapes with antiderivatives, f is the shape, F1 and F2 its first and second antiderivatives, all in terms of
+    //the input before the drive so a drive change between blocks doesn't throw the differences off
+    struct HardClip
+    {
+        double drive;
+
+        double f(double x) const    { return juce::jlimit(-1.0, 1.0, drive * x); }
+
+        double F1(double x) const
+        {
+            auto u = drive * x;
+            return (std::abs(u) <= 1.0 ? 0.5 * u * u : std::abs(u) - 0.5) / drive;
+        }
+
+        double F2(double x) const
+        {
+            auto u = drive * x;
+            auto sign = u < 0.0 ? -1.0 : 1.0;
+            return (std::abs(u) <= 1.0 ? u * u * u / 6.0 : sign * (0.5 * u * u + 1.0 / 6.0) - 0.5 * u) / (drive * drive);
+        }
+    };
+
+    //the cubic soft clip, it clips on the input and the drive only scales the cubic part
+    struct SoftClip
+    {
+        double drive;
+
+        double f(double x) const
+        {
+            if (x < -1.0) return -0.9;
+            if (x > 1.0)  return 0.9;
+            return drive * (x - x * x * x / 3.0);
+        }
+
+        double F1(double x) const
+        {
+            auto a = std::abs(x);
+
+            if (a <= 1.0)
+                return drive * (0.5 * x * x - x * x * x * x / 12.0);
+
+            return drive * 5.0 / 12.0 + 0.9 * (a - 1.0);
+        }
+
+        double F2(double x) const
+        {
+            auto a = std::abs(x);
+
+            if (a <= 1.0)
+                return drive * (x * x * x / 6.0 - x * x * x * x * x / 60.0);
+
+            auto sign = x < 0.0 ? -1.0 : 1.0;
+            auto over = a - 1.0;
+            return sign * (drive * 3.0 / 20.0 + drive * 5.0 / 12.0 * over + 0.45 * over * over);
+        }
+    };
+
+    struct Saturation
+    {
+        double drive;
+
+        double f(double x) const    { return std::tanh(drive * x); }
+        double F1(double x) const   { return ShapingFunctions::logCosh(drive * x) / drive; }
+        double F2(double x) const   { return ShapingFunctions::logCoshIntegral(drive * x) / (drive * drive); }
+    };
+
+    //below these differences the divided differences fall apart and the midpoint versions take over
+    const double firstOrderTolerance    = 1.0e-5;
+    const double secondOrderTolerance   = 1.0e-3;
+
+    //y[n] = (F1(x[n]) - F1(x[n-1])) / (x[n] - x[n-1])
+    template <typename Shape>
+    void processFirstOrder(const Shape& shape, float* samples, int numSamples, Distortion::AntiAliasState& state)
+    {
+        auto x1 = state.previous[0];
+        auto x2 = state.previous[1];
+        auto F1x1 = shape.F1(x1);
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            double x = samples[i];
+            auto F1x = shape.F1(x);
+            auto difference = x - x1;
+
+            samples[i] = (float) (std::abs(difference) > firstOrderTolerance ? (F1x - F1x1) / difference
+                                                                              : shape.f(0.5 * (x + x1)));
+            x2 = x1;
+            x1 = x;
+            F1x1 = F1x;
+        }
+
+        state.previous[0] = x1;
+        state.previous[1] = x2;
+    }
+
+    //the second order version, the divided difference of the divided differences of F2
+    template <typename Shape>
+    void processSecondOrder(const Shape& shape, float* samples, int numSamples, Distortion::AntiAliasState& state)
+    {
+        auto x1 = state.previous[0];
+        auto x2 = state.previous[1];
+        auto F2x1 = shape.F2(x1);
+
+        auto firstDifference = [&shape](double a, double b, double F2a, double F2b)
+        {
+            auto difference = a - b;
+            return std::abs(difference) > secondOrderTolerance ? (F2a - F2b) / difference : shape.F1(0.5 * (a + b));
+        };
+
+        auto D1x1 = firstDifference(x1, x2, F2x1, shape.F2(x2));
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            double x = samples[i];
+            auto F2x = shape.F2(x);
+            auto D1x = firstDifference(x, x1, F2x, F2x1);
+            auto difference = x - x2;
+            double y;
+
+            if (std::abs(difference) > secondOrderTolerance)
+            {
+                y = 2.0 * (D1x - D1x1) / difference;
+            }
+            else
+            {
+                //x[n] and x[n-2] are about the same, so go through their midpoint instead
+                auto middle = 0.5 * (x + x2);
+                auto delta = middle - x1;
+
+                if (std::abs(delta) > secondOrderTolerance)
+                    y = 2.0 / delta * (shape.F1(middle) + (F2x1 - shape.F2(middle)) / delta);
+                else
+                    y = shape.f(0.5 * (middle + x1));
+            }
+
+            samples[i] = (float) y;
+            x2 = x1;
+            x1 = x;
+            F2x1 = F2x;
+            D1x1 = D1x;
+        }
+
+        state.previous[0] = x1;
+        state.previous[1] = x2;
+    }
+
+    template <typename Shape>
+    void processAntiAliased(const Shape& shape, float* samples, int numSamples, Distortion::AntiAliasing antiAliasing,
+                            Distortion::AntiAliasState& state)
+    {
+        if (antiAliasing == Distortion::AntiAliasing::firstOrder)
+            processFirstOrder(shape, samples, numSamples, state);
+        else
+            processSecondOrder(shape, samples, numSamples, state);
+    }
+
+    //the same delay as the antiderivative versions for the shapes that don't have one
+    void delayInput(float* samples, int numSamples, Distortion::AntiAliasing antiAliasing, Distortion::AntiAliasState& state)
+    {
+        auto x1 = state.previous[0];
+        auto x2 = state.previous[1];
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            double x = samples[i];
+            samples[i] = (float) (antiAliasing == Distortion::AntiAliasing::firstOrder ? 0.5 * (x + x1) : x1);
+            x2 = x1;
+            x1 = x;
+        }
+
+        state.previous[0] = x1;
+        state.previous[1] = x2;
+    }
+
+    void remember(const float* samples, int numSamples, Distortion::AntiAliasState& state)
+    {
+        if (numSamples > 1)
+        {
+            state.previous[0] = samples[numSamples - 1];
+            state.previous[1] = samples[numSamples - 2];
+        }
+        else if (numSamples == 1)
+        {
+            state.previous[1] = state.previous[0];
+            state.previous[0] = samples[0];
+        }
+    }
+}
+
+static void processShape(int choice, float* samples, int numSamples, const Distortion::Settings& settings);
+
+float Distortion::getAntiAliasingDelay(AntiAliasing antiAliasing)
+{
+    switch (antiAliasing)
+    {
+        case AntiAliasing::firstOrder:  return 0.5f;
+        case AntiAliasing::secondOrder: return 1.0f;
+        case AntiAliasing::off:
+        default:                        return 0.0f;
+    }
+}
+
+void Distortion::process(int choice, float* samples, int numSamples, const Settings& settings, AntiAliasState& state)
+{
+    auto antiAliasing = settings.antiAliasing;
+    double drive = settings.drive;
+
+    if (antiAliasing == AntiAliasing::off)
+    {
+        remember(samples, numSamples, state);
+        processShape(choice, samples, numSamples, settings);
+    }
+    else
+    {
+        switch (choice)
+        {
+            case 0:     processAntiAliased(HardClip{ drive }, samples, numSamples, antiAliasing, state); break;
+            case 1:     processAntiAliased(SoftClip{ drive }, samples, numSamples, antiAliasing, state); break;
+            case 4:     processAntiAliased(Saturation{ drive }, samples, numSamples, antiAliasing, state); break;
+            default:
+                delayInput(samples, numSamples, antiAliasing, state);
+                processShape(choice, samples, numSamples, settings);
+                break;
+        }
+    }
+
+    //the old switch had no breaks, the custom shape came after it and never did this
+    if (settings.chainedShapes && choice >= 0)
+        for (auto next = choice + 1; next <= 5; ++next)
+            processShape(next, samples, numSamples, settings);
+}
+
+static void processShape(int choice, float* samples, int numSamples, const Distortion::Settings& settings)
+{
+    auto gain       = settings.gain;
+    auto drive      = settings.drive;
+    auto quality    = settings.quality;
+    auto& kernels   = DspKernels::get();
+
+    //the switch sits outside the loop so every shape gets its own tight loop, built for the widest vectors we have
+    switch (choice)
+    {
+        //hard clip
+        case 0:
+        {
+            kernels.hardClip(samples, numSamples, drive);
+            break;
+        }
+        //soft clip
+        case 1:
+        {
+            kernels.softClip(samples, numSamples, drive);
+            break;
+        }
+        //overdrive
+        case 2:
+        {
+            ShapingFunctions::wrap(samples, numSamples, drive);
+            break;
+        }
+        //ZAP
+        case 3:
+        {
+            ShapingFunctions::sinHalfPi(samples, numSamples, drive, quality);
+            break;
+        }
+        //saturation
+        case 4:
+        {
+            ShapingFunctions::tanh(samples, numSamples, drive, quality);
+            break;
+        }
+        //wave shapper
+        case 5:
+        {
+            kernels.waveShape(samples, numSamples, drive, gain);
+            break;
+        }
+        //the user drawn curve
+        case 7:
+        {
+            if (settings.customCurve != nullptr)
+                settings.customCurve->process(samples, numSamples, drive);
+            break;
+        }
+        //simple bypass
+        default:
+            break;
+    }
+}
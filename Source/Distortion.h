@@ -0,0 +1,42 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "ShapingFunctions.h"
+#include "TransferCurve.h"
+
+//the waveshapers behind the Distortion Type choice, in the same order as the choice list
+namespace Distortion
+{
+    //antiderivative anti-aliasing, the Anti-Aliasing choice
+    //the first order one runs half a sample late and the second order one a whole sample late
+    //hard clip, soft clip and saturation have antiderivative versions, the other shapes just get delayed
+    //by the same amount so a crossfade between two shapes still lines up
+    //the drive stage's own dry side is delayed by the same fraction so Distortion Mix lines up, but the host can only
+    //be told about whole samples, so with first order at 1x the plugin's output is half a sample later than it reports
+    enum class AntiAliasing { off, firstOrder, secondOrder };
+
+    //the last two samples that went into the shape on one channel, kept even while anti-aliasing is off
+    //so turning it on doesn't start from silence
+    struct AntiAliasState
+    {
+        double previous[2] = { 0.0, 0.0 };
+    };
+
+    //how late the output is for the given order, in samples at whatever rate the shape runs at
+    float getAntiAliasingDelay(AntiAliasing antiAliasing);
+
+    //everything about the shapes that stays the same for the whole block
+    struct Settings
+    {
+        float gain      = 1.0f;     //the plain knob value, the wave shaper uses it
+        float drive     = 1.0f;     //the distortion gain plus the entropy offset
+        ShapingFunctions::Quality quality   = ShapingFunctions::Quality::polynomial;   //the sin and tanh shapes
+        AntiAliasing antiAliasing           = AntiAliasing::off;
+        const TransferTable* customCurve    = nullptr;      //the Custom shape, bypassed while there isn't one
+        bool chainedShapes                  = false;        //sessions from before state version 2, see PluginState.h
+    };
+
+    //runs the chosen shape over a block of samples in place, with chainedShapes the shapes from hard clip to the
+    //wave shaper run on into every one after them, only the first of them gets anti-aliased
+    void process(int choice, float* samples, int numSamples, const Settings& settings, AntiAliasState& state);
+}
@@ -0,0 +1,262 @@
+#include "DspKernels.h"
+
+#include <JuceHeader.h>
+
+namespace DspKernels
+{
+    //nullptr means the baseline, so get() works before anything was ever selected
+    static std::atomic<const Table*> activeTable{ nullptr };
+
+    //-1 if nothing is forced, otherwise the Isa
+    static std::atomic<int> forcedIsa{ -1 };
+
+    static const Table* getTable(Isa isa)
+    {
+        switch (isa)
+        {
+            case Isa::avx2:     return getAvx2Table();
+            case Isa::avx512:   return getAvx512Table();
+            case Isa::baseline:
+            default:            return getBaselineTable();
+        }
+    }
+
+    //what the environment variable asks for, -1 if it isn't set or isn't a name we know
+    static int getIsaFromEnvironment()
+    {
+        auto name = juce::SystemStats::getEnvironmentVariable("REALMAGIVERB_ISA", {}).trim().toLowerCase();
+
+        for (auto isa : { Isa::baseline, Isa::avx2, Isa::avx512 })
+            if (name == getName(isa))
+                return (int) isa;
+
+        return -1;
+    }
+
+    const Table& get() noexcept
+    {
+        auto* table = activeTable.load(std::memory_order_acquire);
+        return table != nullptr ? *table : *getBaselineTable();
+    }
+
+    void select()
+    {
+        auto isa = Isa::baseline;
+
+        if (isAvailable(Isa::avx512))
+            isa = Isa::avx512;
+        else if (isAvailable(Isa::avx2))
+            isa = Isa::avx2;
+
+        auto forced = forcedIsa.load();
+
+        if (forced < 0)
+            forced = getIsaFromEnvironment();
+
+        if (forced >= 0)
+        {
+            if (isAvailable((Isa) forced))
+                isa = (Isa) forced;
+            else
+                DBG("DspKernels: " << getName((Isa) forced) << " was forced but this cpu or build can't run it");
+        }
+
+       #if JUCE_DEBUG
+        //only worth doing once, the tables never change
+        static std::atomic<bool> verified{ false };
+
+        if (! verified.exchange(true))
+        {
+            for (auto other : { Isa::avx2, Isa::avx512 })
+                if (isAvailable(other))
+                    jassert(verify(other));
+        }
+       #endif
+
+        auto* table = getTable(isa);
+
+        if (activeTable.exchange(table) != table)
+            DBG("DspKernels: using " << getName(isa));
+    }
+
+    void forceIsa(Isa isa)
+    {
+        forcedIsa.store((int) isa);
+    }
+
+    void clearForcedIsa()
+    {
+        forcedIsa.store(-1);
+    }
+
+    bool isAvailable(Isa isa)
+    {
+        if (getTable(isa) == nullptr)
+            return false;
+
+        switch (isa)
+        {
+            case Isa::avx2:     return juce::SystemStats::hasAVX2();
+            case Isa::avx512:   return juce::SystemStats::hasAVX512F();
+            case Isa::baseline:
+            default:            return true;
+        }
+    }
+
+    bool verify(Isa isa)
+    {
+        auto* reference = getBaselineTable();
+        auto* table = isAvailable(isa) ? getTable(isa) : nullptr;
+
+        if (table == nullptr)
+            return false;
+
+        //an odd length so every version runs its leftover samples too
+        const int numSamples = 1027;
+
+        std::vector<float> signal((size_t) numSamples);
+        juce::Random random(1770);
+
+        for (auto& sample : signal)
+            sample = (random.nextFloat() * 2.0f - 1.0f) * 4.0f;
+
+        //the points the curves bend or wrap at
+        signal[0] = 0.0f;
+        signal[1] = 1.0f;
+        signal[2] = -1.0f;
+        signal[3] = 4.8f;
+        signal[4] = -0.5f;
+
+        //runs a kernel of both versions on a copy of the signal each and compares the bits
+        auto matches = [&signal](const std::function<void(const Table&, float*)>& kernel, const Table& a, const Table& b)
+        {
+            auto x = signal;
+            auto y = signal;
+            kernel(a, x.data());
+            kernel(b, y.data());
+            return std::memcmp(x.data(), y.data(), x.size() * sizeof(float)) == 0;
+        };
+
+        //a line table and a delay line with something in them
+        const int tableSize = 64;
+        std::vector<float> intercepts((size_t) tableSize + 1), slopes((size_t) tableSize + 1);
+
+        for (int i = 0; i <= tableSize; ++i)
+        {
+            slopes[(size_t) i]      = random.nextFloat() * 0.05f;
+            intercepts[(size_t) i]  = random.nextFloat() - 0.5f;
+        }
+
+        const int lineLength = 256;
+        std::vector<float> line((size_t) lineLength * 2 * 2);
+
+        for (auto& sample : line)
+            sample = random.nextFloat() * 2.0f - 1.0f;
+
+        auto delay = [&](const Table& kernels, float* output, int interpolation)
+        {
+            std::vector<int> index((size_t) numSamples);
+            std::vector<float> fraction((size_t) numSamples);
+            kernels.delayPositions(index.data(), fraction.data(), numSamples, lineLength + 100, 0.37f, 0.013f);
+
+            DelayTaps taps{ line.data(), 2, lineLength - 1, index.data(), fraction.data(), output, 0.2f, 0.0005f, numSamples };
+
+            if (interpolation == 0)         kernels.delayLinear(taps);
+            else if (interpolation == 1)    kernels.delayCubic(taps);
+            else                            kernels.delayLagrange(taps);
+
+            //the positions have to match as well
+            for (int i = 0; i < numSamples; ++i)
+                output[i] += (float) index[(size_t) i] + fraction[(size_t) i];
+        };
+
+        bool ok = true;
+
+        ok = ok && matches([](const Table& k, float* s) { k.hardClip(s, numSamples, 1.7f); }, *reference, *table);
+        ok = ok && matches([](const Table& k, float* s) { k.softClip(s, numSamples, 1.7f); }, *reference, *table);
+        ok = ok && matches([](const Table& k, float* s) { k.waveShape(s, numSamples, 1.7f, 0.3f); }, *reference, *table);
+        ok = ok && matches([](const Table& k, float* s) { k.wrap(s, numSamples, 1.7f); }, *reference, *table);
+        ok = ok && matches([](const Table& k, float* s) { k.sinHalfPi(s, numSamples, 1.7f); }, *reference, *table);
+        ok = ok && matches([](const Table& k, float* s) { k.tanh(s, numSamples, 1.7f); }, *reference, *table);
+        ok = ok && matches([](const Table& k, float* s) { k.quantise(s, numSamples, 256.0f); }, *reference, *table);
+
+        //noise for the whole signal, a length that ends in the middle of the lanes, then the state that's left
+        ok = ok && matches([](const Table& k, float* s)
+                           {
+                               unsigned int state[noiseLanes];
+
+                               for (int lane = 0; lane < noiseLanes; ++lane)
+                                   state[lane] = 2463534242u + (unsigned int) lane * 7919u;
+
+                               k.ditherNoise(s, numSamples - noiseLanes, state);
+                               std::memcpy(s + numSamples - noiseLanes, state, sizeof(state));
+                           }, *reference, *table);
+
+        //the signal itself makes the noise, scaled down to steps
+        ok = ok && matches([](const Table& k, float* s)
+                           {
+                               std::vector<float> noise(s, s + numSamples);
+
+                               for (auto& value : noise)
+                                   value *= 0.25f;
+
+                               k.ditheredQuantise(s, numSamples, 16.0f, noise.data());
+                           }, *reference, *table);
+
+        ok = ok && matches([](const Table& k, float* s)
+                           {
+                               std::vector<float> noise(s, s + numSamples);
+                               float error = 0.3f;
+
+                               for (auto& value : noise)
+                                   value *= 0.25f;
+
+                               k.shapedQuantise(s, numSamples - 1, 16.0f, noise.data(), &error);
+                               s[numSamples - 1] = error;
+                           }, *reference, *table);
+        ok = ok && matches([&](const Table& k, float* s) { k.lineTable(s, numSamples, 0.4f, intercepts.data(), slopes.data(), tableSize); },
+                           *reference, *table);
+
+        for (int interpolation = 0; interpolation < 3; ++interpolation)
+            ok = ok && matches([&](const Table& k, float* s) { delay(k, s, interpolation); }, *reference, *table);
+
+        //the signal as frames of four, a pair of biquads that's stable, the state and the sums come out in the signal
+        ok = ok && matches([](const Table& k, float* s)
+                           {
+                               const float coefficients[] = { 1.5f, -2.6f, 1.2f, -1.7f, 0.73f, 1.0f, -2.0f, 1.0f, -1.99f, 0.99f };
+                               float state[16] = {}, sums[4] = {};
+                               k.filteredPower(s, numSamples / 4 - 4, coefficients, state, sums);
+                               std::memcpy(s + (numSamples / 4 - 4) * 4, state, sizeof(state));
+                               std::memcpy(s, sums, sizeof(sums));
+                           }, *reference, *table);
+
+        //three points of a made up 16 tap interpolator, the history is the start of the signal
+        std::vector<float> interpolator(3 * 16);
+
+        for (auto& coefficient : interpolator)
+            coefficient = random.nextFloat() - 0.5f;
+
+        ok = ok && matches([&interpolator](const Table& k, float* s)
+                           {
+                               std::vector<float> peaks((size_t) numSamples - 15);
+                               k.intervalPeaks(s, numSamples - 15, interpolator.data(), 16, peaks.data());
+                               std::memcpy(s, peaks.data(), peaks.size() * sizeof(float));
+                           }, *reference, *table);
+
+        if (! ok)
+            DBG("DspKernels: " << getName(isa) << " doesn't match the baseline");
+
+        return ok;
+    }
+
+    const char* getName(Isa isa)
+    {
+        switch (isa)
+        {
+            case Isa::avx2:     return "avx2";
+            case Isa::avx512:   return "avx512";
+            case Isa::baseline:
+            default:            return "baseline";
+        }
+    }
+}
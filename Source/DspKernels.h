@@ -0,0 +1,122 @@
+#pragma once
+
+/*the hot per sample loops, built once for every instruction set we care about and picked at runtime
+
+the release build targets a plain baseline so it runs anywhere, which leaves the vectorised loops at sse2 width on
+machines that could do a lot more, so the loops live in DspKernelsBody.h and get compiled again in their own
+translation units for avx2 and avx-512, prepareToPlay picks the widest one the cpu has
+
+    baseline    whatever the build targets, sse2 on x86 and neon on arm
+    avx2        x86 only, gcc, clang and msvc release builds
+    avx512      x86 only, gcc, clang and msvc release builds, avx-512 f
+
+gcc and clang build the wide versions with target attributes instead of per file compiler flags, so only the kernels
+themselves use the wider instructions and nothing they share with the rest of the plugin gets built wide by accident
+
+msvc has no target attribute, so the jucer gives the two wide files the AVX2 and AVX512 compiler flag schemes
+(/arch:AVX2 and /arch:AVX512), everything of ours in them has internal linkage, but the few std helpers the curves
+call are still inline functions the linker shares between units, a release build inlines every one of them while a
+debug build calls them, so msvc debug builds leave the wide files empty and stay on the baseline
+
+every kernel only does elementwise float maths with no fused multiply adds and no reordering, so every version gives
+exactly the same output, debug builds check that bit for bit when a version gets picked
+
+the kernels themselves have no juce in them, so they can be built and measured on their own*/
+namespace DspKernels
+{
+    enum class Isa { baseline, avx2, avx512 };
+
+    //how many xorshift generators ditherNoise runs side by side, its state is this many nonzero words
+    const int noiseLanes = 8;
+
+    //where a chorus voice reads from over a block, see EnsembleChorus
+    struct DelayTaps
+    {
+        const float* line;      //interleaved frames, mirrored so the four taps never wrap
+        int stride;             //floats per frame
+        int mask;
+        const int* index;       //the frame before each read position
+        const float* fraction;  //how far past that frame the read is
+        float* output;          //added into
+        float startGain;
+        float gainStep;
+        int numSamples;
+    };
+
+    struct Table
+    {
+        Isa isa;
+
+        //the distortion shapes, drive * x through the curve, in place
+        void (*hardClip)    (float* samples, int numSamples, float drive);
+        void (*softClip)    (float* samples, int numSamples, float drive);
+        void (*waveShape)   (float* samples, int numSamples, float drive, float gain);
+        void (*wrap)        (float* samples, int numSamples, float drive);
+        void (*sinHalfPi)   (float* samples, int numSamples, float drive);     //the polynomial tier
+        void (*tanh)        (float* samples, int numSamples, float drive);     //the polynomial tier
+
+        //drive * x through a table of lines over [-1, 1], y = intercept + slope * position, see TransferTable
+        void (*lineTable)   (float* samples, int numSamples, float drive, const float* intercepts, const float* slopes,
+                             int size);
+
+        //rounds every sample towards zero onto a grid of 1 / levels
+        void (*quantise)    (float* samples, int numSamples, float levels);
+
+        //triangular noise between -1 and 1, one xorshift step of a lane for every value, the two halves of the word
+        //are the two uniforms it's the difference of
+        void (*ditherNoise) (float* noise, int numSamples, unsigned int* state);
+
+        //rounds every sample to the nearest point on a grid of 1 / levels after adding noise steps of it
+        void (*ditheredQuantise)(float* samples, int numSamples, float levels, const float* noise);
+
+        //the same with the error of every sample taken off the next, which pushes the noise up towards nyquist,
+        //error is the one carried over between blocks, in steps
+        void (*shapedQuantise)  (float* samples, int numSamples, float levels, const float* noise, float* error);
+
+        //the read positions of a chorus voice whose delay ramps by step per sample, origin is the frame the
+        //whole part of the delay ends on
+        void (*delayPositions)(int* index, float* fraction, int numSamples, int origin, float part, float step);
+
+        //a chorus voice's taps, linear, catmull rom and third order lagrange
+        void (*delayLinear)   (const DelayTaps& taps);
+        void (*delayCubic)    (const DelayTaps& taps);
+        void (*delayLagrange) (const DelayTaps& taps);
+
+        //four channels through the same two biquads in series, frames interleaved four wide, adds the square of every
+        //filtered sample into its channel's sum, see LoudnessMeter
+        //coefficients are b0 b1 b2 a1 a2 of the first biquad then the second, state is z1 and z2 of every channel for
+        //the first then the second, 16 floats, a0 is always 1
+        void (*filteredPower) (const float* frames, int numFrames, const float* coefficients, float* state,
+                               float* sumOfSquares);
+
+        //the loudest of every sample and the three points a quarter, a half and three quarters of the way to the next
+        //one, each interpolated by a fir of numTaps, coefficients has the three firs one after the other, see
+        //TruePeakLimiter
+        //samples has numTaps - 1 samples of history in front of the numSamples new ones, the sample a peak is for is
+        //numTaps / 2 behind its new one
+        void (*intervalPeaks) (const float* samples, int numSamples, const float* coefficients, int numTaps,
+                               float* peaks);
+    };
+
+    //the version in use, the baseline until select() picks another one, safe to call from any thread
+    const Table& get() noexcept;
+
+    //picks the widest version this cpu can run, or the forced one if it can run that, message thread
+    //the REALMAGIVERB_ISA environment variable forces one too, baseline, avx2 or avx512, for testing
+    void select();
+    void forceIsa(Isa isa);
+    void clearForcedIsa();
+
+    //whether a version was built into this binary and the cpu can run it
+    bool isAvailable(Isa isa);
+
+    //runs a version and the baseline over the same test signal, true if every output matches bit for bit
+    bool verify(Isa isa);
+
+    const char* getName(Isa isa);
+
+    //the tables themselves, nullptr for the ones that weren't built for this compiler and platform
+    const Table* getBaselineTable();
+    const Table* getAvx2Table();
+    const Table* getAvx512Table();
+}
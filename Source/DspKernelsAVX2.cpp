@@ -0,0 +1,29 @@
+//the kernels at avx2 width, fma is left out on purpose so the results match the baseline exactly
+
+#if (defined (__x86_64__) || defined (__i386__)) && defined (__GNUC__)
+
+ #define DSP_KERNEL          __attribute__ ((target ("avx2")))
+ #define DSP_KERNELS_ISA     DspKernels::Isa::avx2
+ #define DSP_KERNELS_GETTER  getAvx2Table
+
+ #include "DspKernelsBody.h"
+
+#elif defined (_MSC_VER) && (defined (_M_X64) || defined (_M_IX86)) && defined (__AVX2__) && ! defined (_DEBUG)
+
+ //msvc has no target attribute, the jucer builds this file alone with /arch:AVX2 (the AVX2 compiler flag scheme)
+ #define DSP_KERNEL
+ #define DSP_KERNELS_ISA     DspKernels::Isa::avx2
+ #define DSP_KERNELS_GETTER  getAvx2Table
+
+ #include "DspKernelsBody.h"
+
+#else
+
+ #include "DspKernels.h"
+
+ const DspKernels::Table* DspKernels::getAvx2Table()
+ {
+     return nullptr;
+ }
+
+#endif
@@ -0,0 +1,29 @@
+//the kernels at avx-512 width, only the foundation set so any avx-512 cpu can run them
+
+#if (defined (__x86_64__) || defined (__i386__)) && defined (__GNUC__)
+
+ #define DSP_KERNEL          __attribute__ ((target ("avx512f")))
+ #define DSP_KERNELS_ISA     DspKernels::Isa::avx512
+ #define DSP_KERNELS_GETTER  getAvx512Table
+
+ #include "DspKernelsBody.h"
+
+#elif defined (_MSC_VER) && (defined (_M_X64) || defined (_M_IX86)) && defined (__AVX512F__) && ! defined (_DEBUG)
+
+ //msvc has no target attribute, the jucer builds this file alone with /arch:AVX512 (the AVX512 compiler flag scheme)
+ #define DSP_KERNEL
+ #define DSP_KERNELS_ISA     DspKernels::Isa::avx512
+ #define DSP_KERNELS_GETTER  getAvx512Table
+
+ #include "DspKernelsBody.h"
+
+#else
+
+ #include "DspKernels.h"
+
+ const DspKernels::Table* DspKernels::getAvx512Table()
+ {
+     return nullptr;
+ }
+
+#endif
@@ -0,0 +1,7 @@
+//the kernels at whatever the build targets, always there and what every other version gets checked against
+
+#define DSP_KERNEL
+#define DSP_KERNELS_ISA     DspKernels::Isa::baseline
+#define DSP_KERNELS_GETTER  getBaselineTable
+
+#include "DspKernelsBody.h"
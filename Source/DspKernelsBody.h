@@ -0,0 +1,389 @@
+//no pragma once, every DspKernels translation unit includes this once after defining
+//
+//    DSP_KERNEL            what every function in here gets marked with, the target attribute of that unit
+//    DSP_KERNELS_ISA       which DspKernels::Isa the table is
+//    DSP_KERNELS_GETTER    the DspKernels function that hands the table out
+//
+//everything in here is in an anonymous namespace so every unit gets its own copies, nothing built wide can be picked
+//by the linker in place of a baseline one, that goes for the shaping curves too, msvc builds a whole wide unit with
+//its /arch flag and would otherwise hand whichever copy of an inline curve it saw first to the rest of the plugin
+
+//a multiply and an add must never get fused, fused is rounded differently and the versions wouldn't match any more,
+//and nothing here looks at the floating point exception flags, which lets gcc turn the selects into blends
+//this goes before the includes, gcc won't inline the single sample curves into a kernel built with other options
+#if defined (__clang__)
+ #pragma STDC FP_CONTRACT OFF
+#elif defined (__GNUC__)
+ #pragma GCC optimize ("fp-contract=off", "no-trapping-math")
+#elif defined (_MSC_VER)
+ #pragma fp_contract (off)
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include "DspKernels.h"
+
+namespace
+{
+    #include "ShapingCurves.h"
+}
+
+namespace
+{
+    DSP_KERNEL inline float clampKernel(float x, float low, float high) noexcept
+    {
+        return x < low ? low : (high < x ? high : x);
+    }
+
+    DSP_KERNEL void hardClipKernel(float* samples, int numSamples, float drive)
+    {
+        for (int i = 0; i < numSamples; ++i)
+            samples[i] = clampKernel(samples[i] * drive, -1.0f, 1.0f);
+    }
+
+    //the clipping is on the input, the drive only scales the cubic
+    DSP_KERNEL void softClipKernel(float* samples, int numSamples, float drive)
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            auto x = samples[i];
+            auto cubic = drive * (x - ((x * x * x) / 3.0f));
+            samples[i] = x < -1.0f ? -0.9f : (x > 1.0f ? 0.9f : cubic);
+        }
+    }
+
+    DSP_KERNEL void waveShapeKernel(float* samples, int numSamples, float drive, float gain)
+    {
+        for (int i = 0; i < numSamples; ++i)
+            samples[i] = drive * (samples[i] + gain * samples[i] * samples[i]);
+    }
+
+    //same as the old mod(drive * x + 1, 2) - 1
+    DSP_KERNEL void wrapKernel(float* samples, int numSamples, float drive)
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            auto x = drive * samples[i];
+            samples[i] = x - 2.0f * std::floor((x + 1.0f) * 0.5f);
+        }
+    }
+
+    DSP_KERNEL void sinHalfPiKernel(float* samples, int numSamples, float drive)
+    {
+        for (int i = 0; i < numSamples; ++i)
+            samples[i] = ShapingFunctions::sinHalfPiPolynomial(ShapingFunctions::foldHalfPi(drive * samples[i]));
+    }
+
+    DSP_KERNEL void tanhKernel(float* samples, int numSamples, float drive)
+    {
+        for (int i = 0; i < numSamples; ++i)
+            samples[i] = ShapingFunctions::tanhPade(drive * samples[i]);
+    }
+
+    DSP_KERNEL void lineTableKernel(float* samples, int numSamples, float drive, const float* intercepts,
+                                    const float* slopes, int size)
+    {
+        const auto halfSize = 0.5f * (float) size;
+        const auto scale = drive * halfSize;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            auto position = clampKernel(samples[i] * scale + halfSize, 0.0f, (float) size);
+            auto index = (int) position;
+            samples[i] = intercepts[index] + slopes[index] * position;
+        }
+    }
+
+    //the same as x - fmod(x, 1 / levels) while levels is a power of two, which the bit depth always makes it
+    //anything past 2^23 steps is already on the grid and would overflow the int, so there the fraction taken off is
+    //multiplied by zero, a select gcc won't blend, every step of it is exact and a small negative x still ends on +0
+    DSP_KERNEL void quantiseKernel(float* samples, int numSamples, float levels)
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            auto steps = samples[i] * levels;
+            auto whole = (float) (int) clampKernel(steps, -8388608.0f, 8388608.0f);
+            auto offGrid = (float) (std::abs(steps) < 8388608.0f);
+            samples[i] = (steps - (steps - whole) * offGrid) / levels;
+        }
+    }
+
+    //the words go through whole lanes at a time so the loop is as wide as the vectors, a block that doesn't end on a
+    //lane boundary still steps every lane and drops what it doesn't need
+    DSP_KERNEL void ditherNoiseKernel(float* noise, int numSamples, unsigned int* state)
+    {
+        const int lanes = DspKernels::noiseLanes;
+        float values[lanes];
+
+        for (int start = 0; start < numSamples; start += lanes)
+        {
+            for (int lane = 0; lane < lanes; ++lane)
+            {
+                auto x = state[lane];
+                x ^= x << 13;
+                x ^= x >> 17;
+                x ^= x << 5;
+                state[lane] = x;
+
+                values[lane] = (float) ((int) (x & 0xffffu) - (int) (x >> 16)) * (1.0f / 65536.0f);
+            }
+
+            auto todo = numSamples - start < lanes ? numSamples - start : lanes;
+
+            for (int lane = 0; lane < todo; ++lane)
+                noise[start + lane] = values[lane];
+        }
+    }
+
+    //to the nearest whole number, halves to even, adding and taking away 1.5 * 2^23 leaves nothing below the point,
+    //it's two adds where a conversion to int and back would be two slow ones, only right below 2^22
+    DSP_KERNEL inline float roundKernel(float x) noexcept
+    {
+        return (x + 12582912.0f) - 12582912.0f;
+    }
+
+    //what's too big for the rounding is left alone, at those levels it's on the grid anyway
+    DSP_KERNEL void ditheredQuantiseKernel(float* samples, int numSamples, float levels, const float* noise)
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            auto steps = samples[i] * levels;
+            auto rounded = roundKernel(steps + noise[i]) / levels;
+            samples[i] = std::abs(steps) < 4194304.0f ? rounded : samples[i];
+        }
+    }
+
+    //first order, the noise comes out shaped by 1 - z^-1, which stays stable even at one bit
+    //the noise is added before the error comes off and the error is worked out against the noisy value, so all the
+    //loop carries from one sample to the next is a subtract, the rounding and another subtract
+    DSP_KERNEL void shapedQuantiseKernel(float* samples, int numSamples, float levels, const float* noise, float* error)
+    {
+        auto last = *error;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            auto steps = samples[i] * levels;
+            auto noisy = (steps + noise[i]) - last;
+            auto rounded = roundKernel(noisy);
+            auto onGrid = std::abs(steps) < 4194304.0f;
+
+            last = onGrid ? rounded - (noisy - noise[i]) : 0.0f;
+            samples[i] = onGrid ? rounded / levels : samples[i];
+        }
+
+        *error = last;
+    }
+
+    //floored by hand, std::floor to an int is a library call on plain sse2
+    DSP_KERNEL void delayPositionsKernel(int* index, float* fraction, int numSamples, int origin, float part, float step)
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            auto behind = part + step * (float) (i + 1);
+            auto truncated = (int) behind;
+            auto frames = truncated - (behind < (float) truncated ? 1 : 0);
+
+            index[i]    = origin + i - frames - 1;
+            fraction[i] = 1.0f - (behind - (float) frames);
+        }
+    }
+
+    enum { linear, cubic, lagrange };
+
+    template <int interpolation>
+    DSP_KERNEL void delayKernel(const DspKernels::DelayTaps& taps)
+    {
+        //copied out so the compiler knows writing the output can't change them
+        const auto* line        = taps.line;
+        const auto* index       = taps.index;
+        const auto* fraction    = taps.fraction;
+        auto* output            = taps.output;
+        const auto stride       = taps.stride;
+        const auto mask         = taps.mask;
+        const auto startGain    = taps.startGain;
+        const auto gainStep     = taps.gainStep;
+        const auto numSamples   = taps.numSamples;
+
+        //the taps are gathered on their own first, the gather stays scalar but that leaves the maths to vectorise
+        const int chunkSize = 64;
+        float taps0[chunkSize], taps1[chunkSize], taps2[chunkSize], taps3[chunkSize];
+
+        for (int start = 0; start < numSamples; start += chunkSize)
+        {
+            auto chunk = numSamples - start < chunkSize ? numSamples - start : chunkSize;
+
+            //one frame before the one the read is past, then three after it
+            for (int i = 0; i < chunk; ++i)
+            {
+                auto base = ((index[start + i] - 1) & mask) * stride;
+                taps0[i] = line[base];
+                taps1[i] = line[base + stride];
+                taps2[i] = line[base + stride * 2];
+                taps3[i] = line[base + stride * 3];
+            }
+
+            for (int i = 0; i < chunk; ++i)
+            {
+                auto f = fraction[start + i];
+                auto x0 = taps0[i];
+                auto x1 = taps1[i];
+                auto x2 = taps2[i];
+                auto x3 = taps3[i];
+
+                float y;
+
+                if (interpolation == linear)
+                {
+                    y = x1 + f * (x2 - x1);
+                }
+                else if (interpolation == cubic)
+                {
+                    //catmull rom
+                    auto c1 = 0.5f * (x2 - x0);
+                    auto c2 = x0 - 2.5f * x1 + 2.0f * x2 - 0.5f * x3;
+                    auto c3 = 0.5f * (x3 - x0) + 1.5f * (x1 - x2);
+                    y = ((c3 * f + c2) * f + c1) * f + x1;
+                }
+                else
+                {
+                    //third order lagrange through the four taps
+                    auto fm1 = f - 1.0f;
+                    auto fm2 = f - 2.0f;
+                    auto fp1 = f + 1.0f;
+                    y = -x0 * f * fm1 * fm2 * (1.0f / 6.0f)
+                      + x1 * fp1 * fm1 * fm2 * 0.5f
+                      - x2 * fp1 * f * fm2 * 0.5f
+                      + x3 * fp1 * f * fm1 * (1.0f / 6.0f);
+                }
+
+                //worked out from the start rather than added up, so it doesn't carry a dependency from sample to sample
+                auto gain = startGain + gainStep * (float) (start + i + 1);
+                output[start + i] += gain * y;
+            }
+        }
+    }
+
+    //transposed direct form II, the four channels side by side fill one sse register, so it's the same width on
+    //every version
+    DSP_KERNEL void filteredPowerKernel(const float* frames, int numFrames, const float* coefficients, float* state,
+                                        float* sumOfSquares)
+    {
+        const int lanes = 4;
+
+        const auto b0 = coefficients[0], b1 = coefficients[1], b2 = coefficients[2];
+        const auto a1 = coefficients[3], a2 = coefficients[4];
+        const auto c0 = coefficients[5], c1 = coefficients[6], c2 = coefficients[7];
+        const auto d1 = coefficients[8], d2 = coefficients[9];
+
+        float z1[lanes], z2[lanes], w1[lanes], w2[lanes], sums[lanes];
+
+        for (int lane = 0; lane < lanes; ++lane)
+        {
+            z1[lane]    = state[lane];
+            z2[lane]    = state[lanes + lane];
+            w1[lane]    = state[lanes * 2 + lane];
+            w2[lane]    = state[lanes * 3 + lane];
+            sums[lane]  = 0.0f;
+        }
+
+        for (int frame = 0; frame < numFrames; ++frame)
+        {
+            for (int lane = 0; lane < lanes; ++lane)
+            {
+                auto x = frames[frame * lanes + lane];
+
+                //the feedback is taken off last, that keeps the loop carried part to an add, a multiply and a subtract
+                auto y = b0 * x + z1[lane];
+                z1[lane] = (b1 * x + z2[lane]) - a1 * y;
+                z2[lane] = b2 * x - a2 * y;
+
+                auto weighted = c0 * y + w1[lane];
+                w1[lane] = (c1 * y + w2[lane]) - d1 * weighted;
+                w2[lane] = c2 * y - d2 * weighted;
+
+                sums[lane] += weighted * weighted;
+            }
+        }
+
+        for (int lane = 0; lane < lanes; ++lane)
+        {
+            state[lane]             = z1[lane];
+            state[lanes + lane]     = z2[lane];
+            state[lanes * 2 + lane] = w1[lane];
+            state[lanes * 3 + lane] = w2[lane];
+            sumOfSquares[lane]     += sums[lane];
+        }
+    }
+
+    //worked out a control block at a time so every tap goes over the whole block, the inner loop runs across the
+    //samples and does all three points off one load, every sum only ever adds to itself, in tap order whatever the width
+    DSP_KERNEL void intervalPeaksKernel(const float* samples, int numSamples, const float* coefficients, int numTaps,
+                                        float* peaks)
+    {
+        const int blockSize = 32;
+        float first[blockSize], second[blockSize], third[blockSize];
+
+        for (int start = 0; start < numSamples; start += blockSize)
+        {
+            auto todo = numSamples - start < blockSize ? numSamples - start : blockSize;
+            auto* input = samples + start;
+            auto* output = peaks + start;
+
+            for (int i = 0; i < todo; ++i)
+                first[i] = second[i] = third[i] = 0.0f;
+
+            for (int j = 0; j < numTaps; ++j)
+            {
+                auto a = coefficients[j];
+                auto b = coefficients[numTaps + j];
+                auto c = coefficients[numTaps * 2 + j];
+
+                for (int i = 0; i < todo; ++i)
+                {
+                    auto x = input[i + j];
+                    first[i]  += a * x;
+                    second[i] += b * x;
+                    third[i]  += c * x;
+                }
+            }
+
+            for (int i = 0; i < todo; ++i)
+            {
+                auto peak = std::abs(input[i + numTaps / 2 - 1]);
+                auto point = std::abs(first[i]);
+                peak = peak < point ? point : peak;
+                point = std::abs(second[i]);
+                peak = peak < point ? point : peak;
+                point = std::abs(third[i]);
+                output[i] = peak < point ? point : peak;
+            }
+        }
+    }
+
+    const DspKernels::Table table =
+    {
+        DSP_KERNELS_ISA,
+        hardClipKernel,
+        softClipKernel,
+        waveShapeKernel,
+        wrapKernel,
+        sinHalfPiKernel,
+        tanhKernel,
+        lineTableKernel,
+        quantiseKernel,
+        ditherNoiseKernel,
+        ditheredQuantiseKernel,
+        shapedQuantiseKernel,
+        delayPositionsKernel,
+        delayKernel<linear>,
+        delayKernel<cubic>,
+        delayKernel<lagrange>,
+        filteredPowerKernel,
+        intervalPeaksKernel
+    };
+}
+
+const DspKernels::Table* DspKernels::DSP_KERNELS_GETTER()
+{
+    return &table;
+}
@@ -0,0 +1,239 @@
+#include "DspThreadPool.h"
+
+bool DspTask::tryRun() noexcept
+{
+    int expected = pending;
+
+    if (! state.compare_exchange_strong(expected, running, std::memory_order_acquire))
+        return false;
+
+    function(context);
+
+    state.store(idle, std::memory_order_release);
+    return true;
+}
+
+void DspTask::waitOrRunInline() noexcept
+{
+    if (tryRun())
+    {
+        //nobody got to it, but it might still be sitting in a queue
+        if (pool != nullptr)
+            pool->retract(*this);
+    }
+    else
+    {
+        //a worker has it, it started before we needed it so it won't take long
+        while (state.load(std::memory_order_acquire) == running)
+            std::this_thread::yield();
+    }
+
+    pool = nullptr;
+}
+
+//==============================================================================
+class DspThreadPool::Worker : public juce::Thread
+{
+public:
+    Worker(DspThreadPool& p, int i) : juce::Thread("MagiFect DSP " + juce::String(i)), owner(p), index(i)
+    {
+    }
+
+    void run() override
+    {
+        int idleRounds = 0;
+
+        while (! threadShouldExit())
+        {
+            if (auto* task = owner.takeTask(index))
+            {
+                //the audio thread might have got to it first, then this does nothing
+                task->tryRun();
+                current.store(nullptr, std::memory_order_release);
+                idleRounds = 0;
+                continue;
+            }
+
+            //spins for a bit in case more of this block is coming, then parks until submit() has something
+            ++idleRounds;
+
+            if (idleRounds < spinRounds)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+
+            //announced before the last look at the queues, so a task submitted after that look always signals
+            parked.store(true, std::memory_order_seq_cst);
+
+            if (owner.hasWork())
+            {
+                parked.store(false, std::memory_order_relaxed);
+                continue;
+            }
+
+            wakeUp.wait();
+            idleRounds = 0;
+        }
+    }
+
+    //wakes the worker if it's parked, only the first call after it parked touches the event
+    void wake() noexcept
+    {
+        if (parked.exchange(false, std::memory_order_seq_cst))
+            wakeUp.signal();
+    }
+
+    //the ring of tasks waiting for this worker, guarded by the spin lock
+    juce::SpinLock lock;
+    DspTask* queue[queueSize];
+    int head    = 0;
+    int count   = 0;
+
+    //the task this worker took out of a queue and hasn't let go of yet
+    std::atomic<DspTask*> current{ nullptr };
+
+    //how long a worker spins with nothing to do before it parks
+    static const int spinRounds = 2000;
+
+private:
+    //the event the worker sleeps on while it's parked, and whether it's (about to be) asleep on it
+    juce::WaitableEvent wakeUp;
+    std::atomic<bool> parked{ false };
+
+    DspThreadPool& owner;
+    int index;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Worker)
+};
+
+//==============================================================================
+DspThreadPool::DspThreadPool()
+{
+    auto numWorkers = juce::jlimit(1, 8, juce::SystemStats::getNumCpus() - 1);
+
+    for (int i = 0; i < numWorkers; ++i)
+        workers.add(new Worker(*this, i));
+
+    for (auto* worker : workers)
+        worker->startThread(8);
+}
+
+DspThreadPool::~DspThreadPool()
+{
+    for (auto* worker : workers)
+    {
+        worker->signalThreadShouldExit();
+        worker->wake();
+    }
+
+    for (auto* worker : workers)
+        worker->stopThread(1000);
+}
+
+bool DspThreadPool::submit(DspTask& task) noexcept
+{
+    jassert(task.state.load() == DspTask::pending);
+
+    auto numWorkers = workers.size();
+    auto first = (int) (nextWorker++ % (unsigned int) numWorkers);
+
+    //round robin, moving on to the next queue if one is full
+    for (int i = 0; i < numWorkers; ++i)
+    {
+        auto* worker = workers.getUnchecked((first + i) % numWorkers);
+
+        {
+            const juce::SpinLock::ScopedLockType sl(worker->lock);
+
+            if (worker->count == queueSize)
+                continue;
+
+            worker->queue[(worker->head + worker->count) % queueSize] = &task;
+            ++worker->count;
+        }
+
+        //the event's own lock is only ever held by a worker going to sleep or waking up, and a worker is
+        //signalled once per park, so this never waits on anything that takes long
+        task.pool = this;
+        worker->wake();
+        return true;
+    }
+
+    return false;
+}
+
+bool DspThreadPool::hasWork() noexcept
+{
+    for (auto* worker : workers)
+    {
+        const juce::SpinLock::ScopedLockType sl(worker->lock);
+
+        if (worker->count > 0)
+            return true;
+    }
+
+    return false;
+}
+
+DspTask* DspThreadPool::takeTask(int index) noexcept
+{
+    auto numWorkers = workers.size();
+
+    for (int i = 0; i < numWorkers; ++i)
+    {
+        auto* worker = workers.getUnchecked((index + i) % numWorkers);
+        auto* self = workers.getUnchecked(index);
+
+        //oldest first from our own queue, newest first when stealing so the owner keeps the work it queued first
+        const juce::SpinLock::ScopedTryLockType sl(worker->lock);
+
+        if (! sl.isLocked() || worker->count == 0)
+            continue;
+
+        DspTask* task;
+
+        if (i == 0)
+        {
+            task = worker->queue[worker->head];
+            worker->head = (worker->head + 1) % queueSize;
+        }
+        else
+        {
+            task = worker->queue[(worker->head + worker->count - 1) % queueSize];
+        }
+
+        --worker->count;
+
+        //set while the queue is still locked, so retract() either finds the task in the queue or sees it here
+        self->current.store(task, std::memory_order_release);
+        return task;
+    }
+
+    return nullptr;
+}
+
+void DspThreadPool::retract(DspTask& task) noexcept
+{
+    for (auto* worker : workers)
+    {
+        const juce::SpinLock::ScopedLockType sl(worker->lock);
+
+        //closes the gap the task leaves behind
+        int kept = 0;
+
+        for (int i = 0; i < worker->count; ++i)
+        {
+            auto* queued = worker->queue[(worker->head + i) % queueSize];
+
+            if (queued != &task)
+                worker->queue[(worker->head + kept++) % queueSize] = queued;
+        }
+
+        worker->count = kept;
+    }
+
+    for (auto* worker : workers)
+        while (worker->current.load(std::memory_order_acquire) == &task)
+            std::this_thread::yield();
+}
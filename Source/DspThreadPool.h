@@ -0,0 +1,81 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+class DspThreadPool;
+
+/*one piece of work the audio thread can hand to the pool, owned by whoever submits it
+
+whoever gets to it first runs it, a worker or the audio thread itself in waitOrRunInline(), so if the pool is busy
+or slow to wake up the work still gets done in time, just not in parallel*/
+struct DspTask
+{
+    using Function = void (*)(void* context);
+
+    DspTask(Function f, void* c) : function(f), context(c) {}
+
+    //marks the task as needing to run, before it's submitted (or left to be run inline later)
+    void arm() noexcept { state.store(pending, std::memory_order_release); }
+
+    //runs the task if it's armed and nobody else has claimed it, true if this call ran it
+    bool tryRun() noexcept;
+
+    //the thread that armed it, once this returns the task has run and no worker is holding on to it
+    void waitOrRunInline() noexcept;
+
+private:
+    friend class DspThreadPool;
+
+    enum State { idle, pending, running };
+    std::atomic<int> state{ idle };
+
+    Function function;
+    void* context;
+
+    //the pool it was last submitted to, only touched by the thread that arms it
+    DspThreadPool* pool = nullptr;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DspTask)
+};
+
+/*worker threads shared by every plugin instance in the process through a juce::SharedResourcePointer,
+one less than there are cores so the host's own audio thread always has one
+
+every worker has its own small queue, submit() spreads tasks over them and a worker with nothing left in its own
+queue steals from the others, so one instance with a heavy block can spread it over all of them
+
+an idle worker spins for a moment and then parks on an event, submit() only signals the worker it queued to and only
+if that one is parked, a task it's late for is still run inline by whoever waits on it*/
+class DspThreadPool
+{
+public:
+    DspThreadPool();
+    ~DspThreadPool();
+
+    //audio thread, never blocks, the task has to be armed
+    //returns false if every queue is full, the task then just runs inline when it's waited on
+    bool submit(DspTask& task) noexcept;
+
+    int getNumWorkers() const noexcept { return workers.size(); }
+
+    static const int queueSize = 64;
+
+private:
+    friend struct DspTask;
+
+    class Worker;
+
+    //takes the task out of every queue and waits for any worker that already popped it to let go of it
+    void retract(DspTask& task) noexcept;
+
+    //true if any queue has a task in it, for a worker about to park
+    bool hasWork() noexcept;
+
+    //the next task for worker "index", from its own queue first and then from the others
+    DspTask* takeTask(int index) noexcept;
+
+    juce::OwnedArray<Worker> workers;
+    std::atomic<unsigned int> nextWorker{ 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DspThreadPool)
+};
@@ -0,0 +1,237 @@
+#include "EnsembleChorus.h"
+
+const int EnsembleChorus::maxVoices;
+constexpr float EnsembleChorus::maxCentreDelayMs;
+constexpr float EnsembleChorus::maxModulationMs;
+
+void EnsembleChorus::prepare(const juce::dsp::ProcessSpec& spec)
+{
+    sampleRate  = spec.sampleRate;
+    blockSize   = juce::jmax(1, (int) spec.maximumBlockSize);
+    numChannels = juce::jlimit(1, 2, (int) spec.numChannels);
+
+    minimumDelay = (float) blockSize + 2.0f;
+
+    //the longest delay plus a block and the taps, rounded up so the wrap is a mask
+    auto longest = (int) std::ceil((maxCentreDelayMs + maxModulationMs) * sampleRate / 1000.0) + blockSize + 4;
+    length  = juce::nextPowerOfTwo(longest);
+    mask    = length - 1;
+
+    delayLine.assign((size_t) length * 2 * (size_t) numChannels, 0.0f);
+
+    for (auto& channel : wet)
+        channel.assign((size_t) blockSize, 0.0f);
+
+    indices.assign((size_t) blockSize, 0);
+    fractions.assign((size_t) blockSize, 0.0f);
+
+    reset();
+}
+
+size_t EnsembleChorus::getSizeInBytes() const noexcept
+{
+    auto size = (delayLine.size() + fractions.size()) * sizeof(float) + indices.size() * sizeof(int);
+
+    for (auto& channel : wet)
+        size += channel.size() * sizeof(float);
+
+    return size;
+}
+
+void EnsembleChorus::reset()
+{
+    std::fill(delayLine.begin(), delayLine.end(), 0.0f);
+    writePosition = 0;
+
+    //evenly around the circle, so the voices never all bunch up
+    for (int voice = 0; voice < maxVoices; ++voice)
+    {
+        auto angle = juce::MathConstants<double>::twoPi * voice / maxVoices;
+        lfoSin[voice] = (float) std::sin(angle);
+        lfoCos[voice] = (float) std::cos(angle);
+    }
+
+    rotationRate    = -1.0f;
+    rotationSamples = 0;
+
+    delaysValid = false;
+}
+
+void EnsembleChorus::process(juce::AudioBuffer<float>& buffer) noexcept
+{
+    if (delayLine.empty())
+        return;
+
+    auto channelsToDo = juce::jmin(numChannels, buffer.getNumChannels());
+    auto numSamples = buffer.getNumSamples();
+    float* channels[2] = {};
+
+    syncPosition = parameters.position;
+
+    for (int start = 0; start < numSamples; start += blockSize)
+    {
+        for (int channel = 0; channel < channelsToDo; ++channel)
+            channels[channel] = buffer.getWritePointer(channel, start);
+
+        processBlock(channels, channelsToDo, juce::jmin(blockSize, numSamples - start));
+    }
+}
+
+void EnsembleChorus::processBlock(float* const* channels, int channelsToDo, int numSamples) noexcept
+{
+    auto numVoices  = juce::jlimit(1, maxVoices, parameters.numVoices);
+    auto msToSamples = (float) (sampleRate / 1000.0);
+
+    //the delay sits at the centre and the lfo only ever adds to it, the centre can't be shorter than a block
+    auto centre = juce::jmax(minimumDelay, juce::jlimit(0.0f, maxCentreDelayMs, parameters.centreDelay) * msToSamples);
+    auto swing  = juce::jlimit(0.0f, 1.0f, parameters.depth) * maxModulationMs * msToSamples;
+
+    //uncorrelated voices add up in power, this keeps the wet about as loud whatever the count
+    auto voiceGain = 1.0f / std::sqrt((float) numVoices);
+
+    for (int channel = 0; channel < channelsToDo; ++channel)
+        juce::FloatVectorOperations::clear(wet[channel].data(), numSamples);
+
+    //synced, only the voices that can be heard need their lfo, the others are worked out again once they're back
+    if (parameters.synced)
+    {
+        syncPosition += parameters.rate * numSamples / sampleRate;
+
+        for (int voice = 0; voice < maxVoices; ++voice)
+        {
+            if (voice >= numVoices && lastGains[voice] == 0.0f)
+                continue;
+
+            //the same detune and spread around the circle as running free
+            auto cycles = syncPosition * (1.0 + 0.07 * voice) + (double) voice / maxVoices;
+            auto angle = (float) (juce::MathConstants<double>::twoPi * (cycles - std::floor(cycles)));
+            lfoSin[voice] = std::sin(angle);
+            lfoCos[voice] = std::cos(angle);
+        }
+    }
+    //how far every lfo turns in a block, only worked out again when the rate or the block length changes
+    else if (parameters.rate != rotationRate || numSamples != rotationSamples)
+    {
+        rotationRate    = parameters.rate;
+        rotationSamples = numSamples;
+
+        for (int voice = 0; voice < maxVoices; ++voice)
+        {
+            //a little detune per voice so they drift against each other
+            auto rate = parameters.rate * (1.0 + 0.07 * voice);
+            auto angle = juce::MathConstants<double>::twoPi * rate * numSamples / sampleRate;
+            rotationSin[voice] = (float) std::sin(angle);
+            rotationCos[voice] = (float) std::cos(angle);
+        }
+    }
+
+    //every lfo keeps running even while its voice is off, so a voice that comes back is where it would have been
+    for (int voice = 0; voice < maxVoices; ++voice)
+    {
+        //the quadrature pair turned by one block, then pulled back onto the unit circle so it doesn't drift
+        if (! parameters.synced)
+        {
+            auto s = lfoSin[voice] * rotationCos[voice] + lfoCos[voice] * rotationSin[voice];
+            auto c = lfoCos[voice] * rotationCos[voice] - lfoSin[voice] * rotationSin[voice];
+            auto correction = 1.5f - 0.5f * (s * s + c * c);
+            lfoSin[voice] = s * correction;
+            lfoCos[voice] = c * correction;
+        }
+
+        //left on the sine and right on the cosine
+        float endDelays[2] = { centre + swing * (0.5f + 0.5f * lfoSin[voice]),
+                               centre + swing * (0.5f + 0.5f * lfoCos[voice]) };
+
+        //voices fade in and out over a block when the count changes
+        auto endGain = voice < numVoices ? voiceGain : 0.0f;
+        auto startGain = delaysValid ? lastGains[voice] : endGain;
+
+        for (int channel = 0; channel < channelsToDo; ++channel)
+        {
+            auto startDelay = delaysValid ? lastDelays[voice][channel] : endDelays[channel];
+            lastDelays[voice][channel] = endDelays[channel];
+
+            if (startGain == 0.0f && endGain == 0.0f)
+                continue;
+
+            readVoice({ wet[channel].data(), channel, numSamples, startDelay, endDelays[channel], startGain, endGain });
+        }
+
+        lastGains[voice] = endGain;
+    }
+
+    delaysValid = true;
+
+    //the write, once per frame for every voice, with the wet fed back in
+    auto feedback = juce::jlimit(0.0f, 0.95f, parameters.feedback);
+    auto stride = numChannels;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        auto position = (writePosition + i) & mask;
+        auto* frame     = delayLine.data() + (size_t) position * (size_t) stride;
+        auto* mirror    = frame + (size_t) length * (size_t) stride;
+
+        for (int channel = 0; channel < channelsToDo; ++channel)
+        {
+            auto value = channels[channel][i] + feedback * wet[channel][i];
+            frame[channel]  = value;
+            mirror[channel] = value;
+        }
+
+        //a single channel fills the right side too, it'd otherwise hold whatever was there when the routing changed
+        for (int channel = channelsToDo; channel < stride; ++channel)
+        {
+            frame[channel]  = frame[0];
+            mirror[channel] = frame[0];
+        }
+    }
+
+    writePosition = (writePosition + numSamples) & mask;
+
+    //and the mix
+    auto mix = juce::jlimit(0.0f, 1.0f, parameters.mix);
+
+    for (int channel = 0; channel < channelsToDo; ++channel)
+    {
+        juce::FloatVectorOperations::multiply(channels[channel], 1.0f - mix, numSamples);
+        juce::FloatVectorOperations::addWithMultiply(channels[channel], wet[channel].data(), mix, numSamples);
+    }
+}
+
+void EnsembleChorus::readVoice(const Voice& voice) noexcept
+{
+    auto numSamples = voice.numSamples;
+    auto& kernels = DspKernels::get();
+
+    //where every sample reads from, worked out as a whole frame and a fraction so the fraction keeps its precision,
+    //the read sits part + step * (i + 1) frames before frame origin + i
+    auto whole = std::floor(voice.startDelay);
+    auto part = voice.startDelay - whole;
+    auto step = (voice.endDelay - voice.startDelay) / (float) numSamples;
+
+    //kept a whole line ahead so the index never goes negative
+    auto origin = writePosition + length - (int) whole;
+
+    kernels.delayPositions(indices.data(), fractions.data(), numSamples, origin, part, step);
+
+    //then the taps, frames are numChannels apart and the mirror means the four taps never wrap
+    DspKernels::DelayTaps taps;
+    taps.line       = delayLine.data() + voice.channel;
+    taps.stride     = numChannels;
+    taps.mask       = mask;
+    taps.index      = indices.data();
+    taps.fraction   = fractions.data();
+    taps.output     = voice.wet;
+    taps.startGain  = voice.startGain;
+    taps.gainStep   = (voice.endGain - voice.startGain) / (float) numSamples;
+    taps.numSamples = numSamples;
+
+    switch (parameters.interpolation)
+    {
+        case Interpolation::cubic:      kernels.delayCubic(taps); break;
+        case Interpolation::lagrange:   kernels.delayLagrange(taps); break;
+        case Interpolation::linear:
+        default:                        kernels.delayLinear(taps); break;
+    }
+}
@@ -0,0 +1,109 @@
+#include "EnvelopeFollower.h"
+
+EnvelopeFollower::EnvelopeFollower()
+{
+}
+
+EnvelopeFollower::~EnvelopeFollower()
+{
+}
+
+void EnvelopeFollower::prepare(double newSampleRate)
+{
+    sampleRate = newSampleRate;
+
+    //force the coefficients to be worked out again for the new rate
+    auto attack     = attackMs;
+    auto release    = releaseMs;
+    attackMs        = -1.0f;
+    releaseMs       = -1.0f;
+
+    if (attack > 0.0f && release > 0.0f)
+        setAttackRelease(attack, release);
+
+    reset();
+}
+
+void EnvelopeFollower::reset()
+{
+    envelope    = 0.0f;
+    hopPeak     = 0.0f;
+    hopFill     = 0;
+}
+
+void EnvelopeFollower::setAttackRelease(float newAttackMs, float newReleaseMs)
+{
+    if (newAttackMs == attackMs && newReleaseMs == releaseMs)
+        return;
+
+    attackMs    = newAttackMs;
+    releaseMs   = newReleaseMs;
+
+    //the smoothing runs once per hop, so the time constants are in hops rather than samples
+    auto hopsPerSecond = sampleRate / hopSize;
+
+    attackCoeff     = (float) std::exp(-1.0 / (juce::jmax(0.01, (double) attackMs) * 0.001 * hopsPerSecond));
+    releaseCoeff    = (float) std::exp(-1.0 / (juce::jmax(0.01, (double) releaseMs) * 0.001 * hopsPerSecond));
+}
+
+void EnvelopeFollower::pushPeak(float peak)
+{
+    auto coeff = peak > envelope ? attackCoeff : releaseCoeff;
+    envelope = peak + coeff * (envelope - peak);
+}
+
+float EnvelopeFollower::process(const juce::AudioBuffer<float>& key, int startSample, int numSamples)
+{
+    auto numChannels = key.getNumChannels();
+
+    if (numChannels == 0)
+        return processSilence(numSamples);
+
+    auto position   = startSample;
+    auto end        = startSample + numSamples;
+
+    while (position < end)
+    {
+        auto todo = juce::jmin(hopSize - hopFill, end - position);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            auto range = juce::FloatVectorOperations::findMinAndMax(key.getReadPointer(channel, position), todo);
+            hopPeak = juce::jmax(hopPeak, -range.getStart(), range.getEnd());
+        }
+
+        hopFill     += todo;
+        position    += todo;
+
+        if (hopFill == hopSize)
+        {
+            pushPeak(hopPeak);
+            hopPeak = 0.0f;
+            hopFill = 0;
+        }
+    }
+
+    return envelope;
+}
+
+float EnvelopeFollower::processSilence(int numSamples)
+{
+    hopFill += numSamples;
+
+    while (hopFill >= hopSize)
+    {
+        pushPeak(hopPeak);
+        hopPeak = 0.0f;
+        hopFill -= hopSize;
+
+        //nothing left to release, skip the rest of the hops
+        if (envelope < 1.0e-6f)
+        {
+            envelope    = 0.0f;
+            hopFill     = 0;
+            break;
+        }
+    }
+
+    return envelope;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+/*peak envelope follower for the sidechain
+
+the key signal is rectified in hops of 16 samples with the vector min/max routines, and only the
+per-hop peaks go through the attack/release smoothing, so the cost per sample is a couple of simd ops
+instead of a branchy one pole filter on every sample of every channel*/
+class EnvelopeFollower
+{
+public:
+    EnvelopeFollower();
+    ~EnvelopeFollower();
+
+    void prepare(double sampleRate);
+    void reset();
+
+    //only recalculates the coefficients when the times actually change
+    void setAttackRelease(float attackMs, float releaseMs);
+
+    //runs over every channel of the key and returns the envelope at the end of the range
+    float process(const juce::AudioBuffer<float>& key, int startSample, int numSamples);
+
+    //lets the envelope fall back to 0 when there's no key, as if the key had gone silent
+    float processSilence(int numSamples);
+
+    float getEnvelope() const noexcept { return envelope; }
+
+    static const int hopSize = 16;
+
+private:
+    double sampleRate   = 44100.0;
+    float attackMs      = -1.0f;
+    float releaseMs     = -1.0f;
+    float attackCoeff   = 0.0f;
+    float releaseCoeff  = 0.0f;
+
+    float envelope      = 0.0f;
+
+    //peak of the hop that is still being filled, and how many samples are in it
+    float hopPeak       = 0.0f;
+    int hopFill         = 0;
+
+    void pushPeak(float peak);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(EnvelopeFollower)
+};
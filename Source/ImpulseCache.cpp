@@ -0,0 +1,251 @@
+#include "ImpulseCache.h"
+
+const int ImpulseSpectra::headBlockSize;
+const int ImpulseSpectra::tailBlockSize;
+
+ImpulseSpectra::ImpulseSpectra(const juce::AudioBuffer<float>& impulse)
+{
+    numChannels = impulse.getNumChannels();
+    numSamples  = impulse.getNumSamples();
+
+    //the head runs headBlockSize late, the tail starts two tail blocks into that shifted impulse so a tail block
+    //has a whole block of time to be worked out
+    auto headLength = juce::jmin(numSamples, tailBlockSize * 2 - headBlockSize);
+    auto tailLength = numSamples - headLength;
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        auto* data = impulse.getReadPointer(channel);
+
+        head.push_back(std::make_shared<const PartitionedImpulse>(data, headLength, headBlockSize));
+        tail.push_back(tailLength > 0 ? std::make_shared<const PartitionedImpulse>(data + headLength, tailLength, tailBlockSize)
+                                      : nullptr);
+    }
+}
+
+size_t ImpulseSpectra::getSizeInBytes() const noexcept
+{
+    size_t size = 0;
+
+    for (auto& partitions : head)
+        size += partitions->getSizeInBytes();
+
+    for (auto& partitions : tail)
+        if (partitions != nullptr)
+            size += partitions->getSizeInBytes();
+
+    return size;
+}
+
+//==============================================================================
+//reads, resamples and partitions one impulse response, or finds it in the cache if it's already loaded
+class ImpulseCache::LoadJob : public juce::ThreadPoolJob
+{
+public:
+    LoadJob(ImpulseCache& c, const juce::File& f, double rate, const void* o, Callback cb)
+        : juce::ThreadPoolJob("Impulse Load"), cache(c), file(f), sampleRate(rate), owner(o), callback(std::move(cb))
+    {
+    }
+
+    const void* getOwner() const noexcept { return owner; }
+
+    JobStatus runJob() override
+    {
+        auto spectra = load();
+
+        //cancel() waits for this, so once it's been asked to stop the owner might not be there anymore
+        if (! shouldExit())
+            callback(spectra);
+
+        return jobHasFinished;
+    }
+
+private:
+    std::shared_ptr<const ImpulseSpectra> load()
+    {
+        //the key comes from what's in the file, not its name, so copies of the same impulse share too
+        juce::MemoryMappedFile mapped(file, juce::MemoryMappedFile::readOnly);
+
+        if (mapped.getData() == nullptr || mapped.getSize() == 0)
+            return nullptr;
+
+        auto key = juce::MD5(mapped.getData(), mapped.getSize()).toHexString() + "@" + juce::String(sampleRate);
+
+        if (auto existing = cache.find(key))
+            return existing;
+
+        juce::AudioBuffer<float> impulse;
+        double fileSampleRate = 0.0;
+
+        if (! read(impulse, fileSampleRate) || shouldExit())
+            return nullptr;
+
+        auto resampled = resample(impulse, fileSampleRate / sampleRate);
+        normalise(resampled);
+
+        if (shouldExit())
+            return nullptr;
+
+        auto spectra = std::make_shared<const ImpulseSpectra>(resampled);
+        cache.store(key, spectra);
+        return spectra;
+    }
+
+    //wav and aiff are read straight out of the mapped file, anything else through a normal reader
+    bool read(juce::AudioBuffer<float>& impulse, double& fileSampleRate)
+    {
+        juce::AudioFormatManager formats;
+        formats.registerBasicFormats();
+
+        std::unique_ptr<juce::AudioFormatReader> reader;
+
+        if (auto* format = formats.findFormatForFileExtension(file.getFileExtension()))
+        {
+            std::unique_ptr<juce::MemoryMappedAudioFormatReader> mappedReader(format->createMemoryMappedReader(file));
+
+            if (mappedReader != nullptr && mappedReader->mapEntireFile())
+                reader = std::move(mappedReader);
+        }
+
+        if (reader == nullptr)
+            reader.reset(formats.createReaderFor(file));
+
+        if (reader == nullptr || reader->lengthInSamples <= 0 || reader->sampleRate <= 0)
+            return false;
+
+        auto numSamples     = (int) juce::jmin(reader->lengthInSamples, (juce::int64) (maxImpulseSeconds * reader->sampleRate));
+        auto numChannels    = (int) juce::jlimit(1u, 2u, reader->numChannels);
+
+        impulse.setSize(numChannels, numSamples);
+        fileSampleRate = reader->sampleRate;
+
+        //in chunks so a cancel doesn't have to wait for a whole long file
+        const int chunkSize = 65536;
+
+        for (int position = 0; position < numSamples; position += chunkSize)
+        {
+            if (shouldExit())
+                return false;
+
+            auto todo = juce::jmin(chunkSize, numSamples - position);
+            reader->read(&impulse, position, todo, position, true, numChannels > 1);
+        }
+
+        return true;
+    }
+
+    static juce::AudioBuffer<float> resample(const juce::AudioBuffer<float>& impulse, double ratio)
+    {
+        if (ratio == 1.0)
+            return impulse;
+
+        auto numSamples = (int) std::ceil(impulse.getNumSamples() / ratio);
+        juce::AudioBuffer<float> resampled(impulse.getNumChannels(), numSamples);
+
+        for (int channel = 0; channel < impulse.getNumChannels(); ++channel)
+        {
+            juce::LagrangeInterpolator interpolator;
+            interpolator.process(ratio, impulse.getReadPointer(channel), resampled.getWritePointer(channel),
+                                 numSamples, impulse.getNumSamples(), 0);
+        }
+
+        return resampled;
+    }
+
+    //every impulse comes out at about the same loudness, no matter how long or hot it was recorded
+    static void normalise(juce::AudioBuffer<float>& impulse)
+    {
+        auto numSamples = impulse.getNumSamples();
+        auto energy = 0.0f;
+
+        for (int channel = 0; channel < impulse.getNumChannels(); ++channel)
+        {
+            auto rms = impulse.getRMSLevel(channel, 0, numSamples);
+            energy += rms * rms * (float) numSamples;
+        }
+
+        if (energy > 0.0f)
+            impulse.applyGain(0.25f / std::sqrt(energy / (float) impulse.getNumChannels()));
+    }
+
+    ImpulseCache& cache;
+    juce::File file;
+    double sampleRate;
+    const void* owner;
+    Callback callback;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LoadJob)
+};
+
+//==============================================================================
+ImpulseCache::ImpulseCache()
+{
+}
+
+ImpulseCache::~ImpulseCache()
+{
+    loader.removeAllJobs(true, 10000);
+}
+
+void ImpulseCache::request(const juce::File& file, double sampleRate, const void* owner, Callback callback)
+{
+    //a newer request from the same owner makes any older one pointless
+    cancel(owner);
+    loader.addJob(new LoadJob(*this, file, sampleRate, owner, std::move(callback)), true);
+}
+
+void ImpulseCache::cancel(const void* owner)
+{
+    struct OwnerSelector : public juce::ThreadPool::JobSelector
+    {
+        explicit OwnerSelector(const void* o) : owner(o) {}
+
+        bool isJobSuitable(juce::ThreadPoolJob* job) override
+        {
+            auto* load = dynamic_cast<LoadJob*>(job);
+            return load != nullptr && load->getOwner() == owner;
+        }
+
+        const void* owner;
+    };
+
+    OwnerSelector selector(owner);
+    loader.removeAllJobs(true, 10000, &selector);
+}
+
+size_t ImpulseCache::getSizeInBytes()
+{
+    const juce::ScopedLock sl(lock);
+
+    size_t size = 0;
+
+    for (auto& entry : entries)
+        if (auto spectra = entry.second.lock())
+            size += spectra->getSizeInBytes();
+
+    return size;
+}
+
+std::shared_ptr<const ImpulseSpectra> ImpulseCache::find(const juce::String& key)
+{
+    const juce::ScopedLock sl(lock);
+
+    auto entry = entries.find(key);
+    return entry != entries.end() ? entry->second.lock() : nullptr;
+}
+
+void ImpulseCache::store(const juce::String& key, std::shared_ptr<const ImpulseSpectra> spectra)
+{
+    const juce::ScopedLock sl(lock);
+
+    //entries nobody uses anymore are swept out whenever a new one goes in
+    for (auto entry = entries.begin(); entry != entries.end();)
+    {
+        if (entry->second.expired())
+            entry = entries.erase(entry);
+        else
+            ++entry;
+    }
+
+    entries[key] = spectra;
+}
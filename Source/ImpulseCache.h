@@ -0,0 +1,68 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "PartitionedConvolver.h"
+
+//an impulse response ready for the convolution engine, resampled, normalised and cut into head and tail partitions
+//it's never written to after it's built, every engine using the same file at the same sample rate shares one
+struct ImpulseSpectra
+{
+    static const int headBlockSize = 64;
+    static const int tailBlockSize = 1024;
+
+    ImpulseSpectra(const juce::AudioBuffer<float>& impulse);
+
+    //one of each per channel of the impulse, the tail ones are nullptr if the impulse fits in the head
+    std::vector<std::shared_ptr<const PartitionedImpulse>> head, tail;
+
+    int numChannels = 0;
+    int numSamples  = 0;
+
+    size_t getSizeInBytes() const noexcept;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ImpulseSpectra)
+};
+
+/*one per process, shared by every plugin instance through a juce::SharedResourcePointer
+
+impulse responses are keyed by a hash of the file's contents and the sample rate, so fifty instances on the same
+hall at the same rate all point at one set of spectra, the cache only holds weak references so an impulse
+goes away once the last engine using it does
+
+files are memory mapped, read in chunks and resampled on the cache's own loader thread*/
+class ImpulseCache
+{
+public:
+    ImpulseCache();
+    ~ImpulseCache();
+
+    //what a finished load gets handed, nullptr if the file couldn't be read, called on the loader thread
+    using Callback = std::function<void(std::shared_ptr<const ImpulseSpectra>)>;
+
+    //queues a load and returns straight away, owner is whatever cancel() will be called with later
+    void request(const juce::File& file, double sampleRate, const void* owner, Callback callback);
+
+    //drops every load queued for owner and waits for one that's already running, owners call this before they go away
+    void cancel(const void* owner);
+
+    //how much memory all the impulses alive right now take up
+    size_t getSizeInBytes();
+
+    //anything longer than this gets cut off when it's loaded
+    static constexpr double maxImpulseSeconds = 10.0;
+
+private:
+    class LoadJob;
+
+    //the spectra for a key if something is still using them
+    std::shared_ptr<const ImpulseSpectra> find(const juce::String& key);
+    void store(const juce::String& key, std::shared_ptr<const ImpulseSpectra> spectra);
+
+    juce::CriticalSection lock;
+    std::map<juce::String, std::weak_ptr<const ImpulseSpectra>> entries;
+
+    //one thread, so two instances asking for the same file at once load it once
+    juce::ThreadPool loader{ 1 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ImpulseCache)
+};
@@ -0,0 +1,192 @@
+#include "LoudnessMeter.h"
+
+namespace
+{
+    const float silenceLufs = -100.0f;
+
+    //bs.1770 from a mean square, the channel weights of left and right are both 1
+    float toLufs(double energy)
+    {
+        return energy > 0.0 ? juce::jmax(silenceLufs, (float) (-0.691 + 10.0 * std::log10(energy))) : silenceLufs;
+    }
+
+    //the analogue prototypes of the k weighting, the high shelf for the head and the rlb high pass, as biquads at
+    //any rate, b0 b1 b2 a1 a2 normalised by a0
+    void getShelf(double sampleRate, float* c)
+    {
+        const double gainDb = 3.999843853973347, f0 = 1681.974450955533, q = 0.7071752369554196;
+
+        auto k  = std::tan(juce::MathConstants<double>::pi * f0 / sampleRate);
+        auto vh = std::pow(10.0, gainDb / 20.0);
+        auto vb = std::pow(vh, 0.4996667741545416);
+        auto a0 = 1.0 + k / q + k * k;
+
+        c[0] = (float) ((vh + vb * k / q + k * k) / a0);
+        c[1] = (float) (2.0 * (k * k - vh) / a0);
+        c[2] = (float) ((vh - vb * k / q + k * k) / a0);
+        c[3] = (float) (2.0 * (k * k - 1.0) / a0);
+        c[4] = (float) ((1.0 - k / q + k * k) / a0);
+    }
+
+    void getHighPass(double sampleRate, float* c)
+    {
+        const double f0 = 38.13547087602444, q = 0.5003270373238773;
+
+        auto k  = std::tan(juce::MathConstants<double>::pi * f0 / sampleRate);
+        auto a0 = 1.0 + k / q + k * k;
+
+        c[0] = 1.0f;
+        c[1] = -2.0f;
+        c[2] = 1.0f;
+        c[3] = (float) (2.0 * (k * k - 1.0) / a0);
+        c[4] = (float) ((1.0 - k / q + k * k) / a0);
+    }
+}
+
+LoudnessMeter::LoudnessMeter()
+{
+    for (int side = 0; side < 2; ++side)
+    {
+        momentary[side].store(silenceLufs);
+        gatedLoudness[side].store(silenceLufs);
+    }
+}
+
+LoudnessMeter::~LoudnessMeter()
+{
+}
+
+void LoudnessMeter::prepare(double sampleRate, int maxBlockSize)
+{
+    getShelf(sampleRate, coefficients);
+    getHighPass(sampleRate, coefficients + 5);
+
+    frames.assign((size_t) juce::jmax(1, maxBlockSize) * lanes, 0.0f);
+
+    hopLength = juce::jmax(1, juce::roundToInt(sampleRate * 0.1));
+
+    //3 and 10 second time constants, in hops
+    runningCoefficient  = 1.0 - std::exp(-0.1 / 3.0);
+    gateCoefficient     = (float) (1.0 - std::exp(-0.1 / 10.0));
+
+    reset();
+}
+
+void LoudnessMeter::reset()
+{
+    std::fill(std::begin(state), std::end(state), 0.0f);
+    std::fill(std::begin(hopSums), std::end(hopSums), 0.0f);
+    numFrames   = 0;
+    hopPosition = 0;
+    hopIndex    = 0;
+    hopsFilled  = 0;
+
+    for (int side = 0; side < 2; ++side)
+    {
+        runningEnergy[side] = 0.0;
+        gateLevel[side] = silenceLufs;
+        momentary[side].store(silenceLufs);
+        gatedLoudness[side].store(silenceLufs);
+    }
+
+    matchingGain = 1.0f;
+}
+
+void LoudnessMeter::pushInput(const juce::AudioBuffer<float>& buffer) noexcept
+{
+    numFrames = juce::jmin(buffer.getNumSamples(), (int) frames.size() / lanes);
+
+    //a mono input is one channel, the other lane stays silent
+    auto* left  = buffer.getNumChannels() > 0 ? buffer.getReadPointer(0) : nullptr;
+    auto* right = buffer.getNumChannels() > 1 ? buffer.getReadPointer(1) : nullptr;
+
+    for (int i = 0; i < numFrames; ++i)
+    {
+        frames[(size_t) (i * lanes)]     = left  != nullptr ? left[i]  : 0.0f;
+        frames[(size_t) (i * lanes + 1)] = right != nullptr ? right[i] : 0.0f;
+    }
+}
+
+void LoudnessMeter::pushOutput(const juce::AudioBuffer<float>& buffer) noexcept
+{
+    jassert(buffer.getNumSamples() >= numFrames);
+
+    auto* left  = buffer.getNumChannels() > 0 ? buffer.getReadPointer(0) : nullptr;
+    auto* right = buffer.getNumChannels() > 1 ? buffer.getReadPointer(1) : nullptr;
+
+    for (int i = 0; i < numFrames; ++i)
+    {
+        frames[(size_t) (i * lanes + 2)] = left  != nullptr ? left[i]  : 0.0f;
+        frames[(size_t) (i * lanes + 3)] = right != nullptr ? right[i] : 0.0f;
+    }
+
+    measure();
+}
+
+void LoudnessMeter::measure() noexcept
+{
+    auto& kernels = DspKernels::get();
+    int done = 0;
+
+    while (done < numFrames)
+    {
+        auto todo = juce::jmin(numFrames - done, hopLength - hopPosition);
+        kernels.filteredPower(frames.data() + done * lanes, todo, coefficients, state, hopSums);
+
+        done        += todo;
+        hopPosition += todo;
+
+        if (hopPosition == hopLength)
+            closeHop();
+    }
+
+    numFrames = 0;
+}
+
+void LoudnessMeter::closeHop() noexcept
+{
+    for (int side = 0; side < 2; ++side)
+        hopEnergies[hopIndex][side] = ((double) hopSums[side * 2] + (double) hopSums[side * 2 + 1]) / hopLength;
+
+    std::fill(std::begin(hopSums), std::end(hopSums), 0.0f);
+    hopPosition = 0;
+    hopIndex    = (hopIndex + 1) % hopsPerBlock;
+    hopsFilled  = juce::jmin(hopsFilled + 1, hopsPerBlock);
+
+    if (hopsFilled < hopsPerBlock)
+        return;
+
+    //the 400 ms block that just ended, then the gates
+    for (int side = 0; side < 2; ++side)
+    {
+        double energy = 0.0;
+
+        for (auto& hop : hopEnergies)
+            energy += hop[side];
+
+        energy /= hopsPerBlock;
+
+        auto lufs = toLufs(energy);
+        momentary[side].store(lufs);
+
+        if (lufs <= -70.0f)
+            continue;
+
+        auto& gate = gateLevel[side];
+        gate = gate > -70.0f ? gate + gateCoefficient * (lufs - gate) : lufs;
+
+        auto& running = runningEnergy[side];
+
+        if (lufs > gate - 10.0f)
+        {
+            running = running > 0.0 ? running + runningCoefficient * (energy - running) : energy;
+            gatedLoudness[side].store(toLufs(running));
+        }
+    }
+
+    if (runningEnergy[0] > 0.0 && runningEnergy[1] > 0.0)
+    {
+        auto db = juce::jlimit(-maxMatchingDb, maxMatchingDb, toLufs(runningEnergy[0]) - toLufs(runningEnergy[1]));
+        matchingGain = juce::Decibels::decibelsToGain(db);
+    }
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "DspKernels.h"
+
+/*k weighted loudness of the plugin's input and output, itu-r bs.1770, and the gain that matches them for Auto Gain
+
+the input's two channels and the output's two go through the k weighting side by side as the four lanes of one
+DspKernels::filteredPower call, which filters and sums the squares in the same pass, so both meters together cost
+one sse wide biquad pair per frame, that and the interleaving is held to 10 ns a frame, Benchmarks/ measures it
+
+the sums get closed every 100 ms, four of those make the 400 ms momentary block, every block that gets through the
+-70 LUFS absolute gate and the relative gate goes into the running level, which is a 3 second average of the gated
+blocks instead of the whole programme so Auto Gain can follow changes
+
+the relative gate sits 10 LU under a slower 10 second average of every block over the absolute gate, in LUFS so it
+comes down by a steady number of LU a second, it can't hang off the running level itself, after a drop of more than
+10 LU nothing would get through any more and the running level would never move again*/
+class LoudnessMeter
+{
+public:
+    LoudnessMeter();
+    ~LoudnessMeter();
+
+    void prepare(double sampleRate, int maxBlockSize);
+    void reset();
+
+    //audio thread, the first two channels of the input before the chain, then of the output after it, always in that
+    //order and with the same number of samples
+    void pushInput(const juce::AudioBuffer<float>& buffer) noexcept;
+    void pushOutput(const juce::AudioBuffer<float>& buffer) noexcept;
+
+    //audio thread, what the output has to be multiplied by to be as loud as the input, holds its last value while
+    //either side is under the gates
+    float getMatchingGain() const noexcept { return matchingGain; }
+
+    //any thread, LUFS of the last 400 ms block and the gated running level, -100 for silence
+    float getInputLoudness() const noexcept     { return momentary[0].load(); }
+    float getOutputLoudness() const noexcept    { return momentary[1].load(); }
+    float getInputLevel() const noexcept        { return gatedLoudness[0].load(); }
+    float getOutputLevel() const noexcept       { return gatedLoudness[1].load(); }
+
+    //how far Auto Gain goes either way
+    static constexpr float maxMatchingDb = 24.0f;
+
+private:
+    static const int lanes = 4;
+    static const int hopsPerBlock = 4;
+
+    //interleaved four wide, the input in lanes 0 and 1 and the output in 2 and 3
+    std::vector<float> frames;
+    int numFrames = 0;
+
+    float coefficients[10] = {};
+    float state[lanes * 4] = {};
+
+    //the hop being filled
+    float hopSums[lanes] = {};
+    int hopLength   = 4800;
+    int hopPosition = 0;
+
+    //mean squares of the last four hops, input and output
+    double hopEnergies[hopsPerBlock][2] = {};
+    int hopIndex    = 0;
+    int hopsFilled  = 0;
+
+    //the gated running level as a mean square, 0 until a block got through the gates
+    double runningEnergy[2] = {};
+    double runningCoefficient = 0.0;
+
+    //what the relative gate is measured against, in LUFS, silence until a block got over the absolute gate
+    float gateLevel[2] = { -100.0f, -100.0f };
+    float gateCoefficient = 0.0f;
+
+    float matchingGain = 1.0f;
+
+    std::atomic<float> momentary[2];
+    std::atomic<float> gatedLoudness[2];
+
+    //filters the frames interleaved so far, splitting them where a hop ends
+    void measure() noexcept;
+    void closeHop() noexcept;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LoudnessMeter)
+};
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//which part of the stereo image a stage gets to work on
+enum class StereoRouting
+{
+    stereo,     //left and right, like it always was
+    midSide,    //mid on the first channel, side on the second
+    midOnly,    //only the mid gets processed, the side passes through
+    sideOnly    //only the side gets processed, the mid passes through
+};
+
+namespace MidSide
+{
+    /*L/R <-> M/S in place
+    scaled by 1/sqrt(2) the matrix is orthonormal and its own inverse, so the same pass
+    encodes and decodes, both channels are read and written in one loop the compiler can vectorise*/
+    inline void convert(float* first, float* second, int numSamples) noexcept
+    {
+        const float scale = 0.70710678f;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            auto a = first[i];
+            auto b = second[i];
+
+            first[i]    = (a + b) * scale;
+            second[i]   = (a - b) * scale;
+        }
+    }
+}
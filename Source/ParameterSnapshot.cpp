@@ -0,0 +1,163 @@
+#include "ParameterSnapshot.h"
+
+const char* const soundParamIDs[numSoundParams] =
+{
+    "Reverb Size",
+    "Reverb Damping",
+    "Reverb Width",
+    "Reverb Dry/Wet",
+    "Modulation Rate",
+    "Modulation Amount",
+    "LowCut Frequency",
+    "HighCut Frequency",
+    "Pre-Gain",
+    "Post-Gain",
+    "Distortion Gain",
+    "Rate Divide",
+    "Bit Depth",
+    "Entropy",
+    "Distortion Type"
+};
+
+const MorphCurve soundParamMorphCurves[numSoundParams] =
+{
+    MorphCurve::linear,         //Reverb Size
+    MorphCurve::linear,         //Reverb Damping
+    MorphCurve::linear,         //Reverb Width
+    MorphCurve::linear,         //Reverb Dry/Wet
+    MorphCurve::exponential,    //Modulation Rate
+    MorphCurve::linear,         //Modulation Amount
+    MorphCurve::exponential,    //LowCut Frequency
+    MorphCurve::exponential,    //HighCut Frequency
+    MorphCurve::exponential,    //Pre-Gain
+    MorphCurve::exponential,    //Post-Gain
+    MorphCurve::exponential,    //Distortion Gain
+    MorphCurve::exponential,    //Rate Divide
+    MorphCurve::linear,         //Bit Depth
+    MorphCurve::linear,         //Entropy
+    MorphCurve::stepped         //Distortion Type, the distortion stage crossfades the two shapes itself
+};
+
+RawParameterArray getRawSoundParameters(juce::AudioProcessorValueTreeState& apvts)
+{
+    RawParameterArray raw;
+
+    for (int i = 0; i < numSoundParams; ++i)
+        raw[(size_t) i] = apvts.getRawParameterValue(soundParamIDs[i]);
+
+    return raw;
+}
+
+SoundParameterArray getSoundParameters(juce::AudioProcessorValueTreeState& apvts)
+{
+    SoundParameterArray parameters;
+
+    for (int i = 0; i < numSoundParams; ++i)
+        parameters[(size_t) i] = apvts.getParameter(soundParamIDs[i]);
+
+    return parameters;
+}
+
+void ParameterSnapshot::capture(const RawParameterArray& raw)
+{
+    for (size_t i = 0; i < raw.size(); ++i)
+        values[i] = raw[i]->load(std::memory_order_relaxed);
+}
+
+void ParameterSnapshot::applyTo(const SoundParameterArray& parameters) const
+{
+    for (size_t i = 0; i < parameters.size(); ++i)
+    {
+        auto* param = parameters[i];
+
+        if (param == nullptr || ! std::isfinite(values[i]))
+            continue;
+
+        //a host gets one automation event per parameter that actually moved, not one per parameter
+        auto normalised = param->convertTo0to1(values[i]);
+
+        if (normalised != param->getValue())
+            param->setValueNotifyingHost(normalised);
+    }
+}
+
+ParameterSnapshot ParameterSnapshot::fromDefaults(juce::AudioProcessorValueTreeState& apvts)
+{
+    ParameterSnapshot snapshot;
+
+    for (int i = 0; i < numSoundParams; ++i)
+        if (auto* param = apvts.getParameter(soundParamIDs[i]))
+            snapshot.values[(size_t) i] = param->convertFrom0to1(param->getDefaultValue());
+
+    return snapshot;
+}
+
+ParameterSnapshot ParameterSnapshot::morph(const ParameterSnapshot& a, const ParameterSnapshot& b, float amount)
+{
+    amount = juce::jlimit(0.0f, 1.0f, amount);
+
+    ParameterSnapshot result;
+
+    for (size_t i = 0; i < result.values.size(); ++i)
+    {
+        auto from   = a.values[i];
+        auto to     = b.values[i];
+
+        switch (soundParamMorphCurves[i])
+        {
+            case MorphCurve::exponential:
+            {
+                //only works between two positive values, anything touching 0 just falls back to a line
+                if (from > 0.0f && to > 0.0f)
+                {
+                    result.values[i] = from * std::pow(to / from, amount);
+                    break;
+                }
+
+                result.values[i] = from + (to - from) * amount;
+                break;
+            }
+            case MorphCurve::stepped:
+            {
+                result.values[i] = amount < 0.5f ? from : to;
+                break;
+            }
+            case MorphCurve::linear:
+            default:
+            {
+                result.values[i] = from + (to - from) * amount;
+                break;
+            }
+        }
+    }
+
+    return result;
+}
+
+juce::ValueTree ParameterSnapshot::toValueTree(const juce::Identifier& type) const
+{
+    juce::ValueTree tree(type);
+
+    for (int i = 0; i < numSoundParams; ++i)
+    {
+        juce::ValueTree param("PARAM");
+        param.setProperty("id", soundParamIDs[i], nullptr);
+        param.setProperty("value", values[(size_t) i], nullptr);
+        tree.appendChild(param, nullptr);
+    }
+
+    return tree;
+}
+
+void ParameterSnapshot::fromValueTree(const juce::ValueTree& tree)
+{
+    for (const auto& param : tree)
+    {
+        auto id     = param.getProperty("id").toString();
+        auto value  = (float) param.getProperty("value", 0.0f);
+
+        for (int i = 0; i < numSoundParams; ++i)
+            if (id == soundParamIDs[i] && std::isfinite(value))
+                values[(size_t) i] = value;
+    }
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//every parameter that makes up the sound of the plugin, in the order they are added to the layout
+enum class SoundParam
+{
+    revSize,
+    revDamp,
+    revWidth,
+    revDryWet,
+    modRate,
+    modAmount,
+    lowCutFreq,
+    highCutFreq,
+    preGain,
+    postGain,
+    distGain,
+    rateDiv,
+    bitDepth,
+    entropy,
+    distChoice,
+    count
+};
+
+const int numSoundParams = (int) SoundParam::count;
+
+//the parameter ids, indexed by SoundParam
+extern const char* const soundParamIDs[numSoundParams];
+
+//how a parameter travels from one snapshot to the other while morphing
+enum class MorphCurve
+{
+    linear,         //straight line between the two values
+    exponential,    //equal ratios per step, for frequencies and gains
+    stepped         //jumps half way, for choices that can't be blended
+};
+
+extern const MorphCurve soundParamMorphCurves[numSoundParams];
+
+//the apvts atomics of every sound parameter, looked up once so the audio thread never searches by name
+using RawParameterArray = std::array<std::atomic<float>*, numSoundParams>;
+
+RawParameterArray getRawSoundParameters(juce::AudioProcessorValueTreeState& apvts);
+
+//the parameters themselves, for the message thread to set without searching by name either
+using SoundParameterArray = std::array<juce::RangedAudioParameter*, numSoundParams>;
+
+SoundParameterArray getSoundParameters(juce::AudioProcessorValueTreeState& apvts);
+
+//a plain copy of the raw (denormalised) value of every sound parameter
+//cheap to copy around, so it's what the audio thread reads and what presets are stored as
+struct ParameterSnapshot
+{
+    std::array<float, numSoundParams> values{};
+
+    float& operator[](SoundParam p)         { return values[(size_t) p]; }
+    float operator[](SoundParam p) const    { return values[(size_t) p]; }
+
+    //reads the current value of every parameter, safe to call from the audio thread
+    void capture(const RawParameterArray& raw);
+
+    //sets every parameter that isn't at the snapshot's value yet and lets the host know, message thread only
+    void applyTo(const SoundParameterArray& parameters) const;
+
+    //snapshot of the default value of every parameter
+    static ParameterSnapshot fromDefaults(juce::AudioProcessorValueTreeState& apvts);
+
+    //blends two snapshots following each parameter's curve, amount goes from 0 (all a) to 1 (all b)
+    static ParameterSnapshot morph(const ParameterSnapshot& a, const ParameterSnapshot& b, float amount);
+
+    //stores the snapshot as PARAM children the same way the apvts does, so it can live in the plugin state
+    juce::ValueTree toValueTree(const juce::Identifier& type) const;
+    void fromValueTree(const juce::ValueTree& tree);
+};
@@ -0,0 +1,118 @@
+#include "PartitionedConvolver.h"
+
+PartitionedImpulse::PartitionedImpulse(const float* impulse, int impulseLength, int newBlockSize)
+{
+    jassert(juce::isPowerOfTwo(newBlockSize));
+
+    blockSize       = newBlockSize;
+    numBins         = blockSize + 1;
+    numPartitions   = juce::jmax(1, (impulseLength + blockSize - 1) / blockSize);
+
+    auto fftSize = blockSize * 2;
+    juce::dsp::FFT fft(juce::roundToInt(std::log2(fftSize)));
+    std::vector<float> fftBuffer((size_t) fftSize * 2);
+
+    spectra.assign((size_t) (numPartitions * numBins * 2), 0.0f);
+
+    //every partition is zero padded to the fft size, overlap-save keeps the second half of the result
+    for (int partition = 0; partition < numPartitions; ++partition)
+    {
+        std::fill(fftBuffer.begin(), fftBuffer.end(), 0.0f);
+
+        auto offset = partition * blockSize;
+        auto length = juce::jmin(blockSize, impulseLength - offset);
+
+        if (impulse != nullptr && length > 0)
+            std::copy(impulse + offset, impulse + offset + length, fftBuffer.begin());
+
+        fft.performRealOnlyForwardTransform(fftBuffer.data(), true);
+        std::copy(fftBuffer.begin(), fftBuffer.begin() + numBins * 2, spectra.begin() + partition * numBins * 2);
+    }
+}
+
+//==============================================================================
+PartitionedConvolver::PartitionedConvolver()
+{
+}
+
+PartitionedConvolver::~PartitionedConvolver()
+{
+}
+
+void PartitionedConvolver::prepare(std::shared_ptr<const PartitionedImpulse> newImpulse)
+{
+    impulse         = std::move(newImpulse);
+    blockSize       = impulse->blockSize;
+    fftSize         = blockSize * 2;
+    numBins         = impulse->numBins;
+    numPartitions   = impulse->numPartitions;
+
+    fft = std::make_unique<juce::dsp::FFT>(juce::roundToInt(std::log2(fftSize)));
+
+    delayLine.assign((size_t) (numPartitions * numBins * 2), 0.0f);
+    inputFrame.assign((size_t) fftSize, 0.0f);
+    fftBuffer.assign((size_t) fftSize * 2, 0.0f);
+    accumulator.assign((size_t) numBins * 2, 0.0f);
+
+    reset();
+}
+
+void PartitionedConvolver::reset()
+{
+    std::fill(delayLine.begin(), delayLine.end(), 0.0f);
+    std::fill(inputFrame.begin(), inputFrame.end(), 0.0f);
+    delayLinePosition = 0;
+}
+
+void PartitionedConvolver::process(const float* input, float* output, const float* partitionGains) noexcept
+{
+    //slide the frame along by one block
+    std::copy(inputFrame.begin() + blockSize, inputFrame.end(), inputFrame.begin());
+    std::copy(input, input + blockSize, inputFrame.begin() + blockSize);
+
+    std::copy(inputFrame.begin(), inputFrame.end(), fftBuffer.begin());
+    std::fill(fftBuffer.begin() + fftSize, fftBuffer.end(), 0.0f);
+    fft->performRealOnlyForwardTransform(fftBuffer.data(), true);
+
+    auto spectrumSize = numBins * 2;
+    std::copy(fftBuffer.begin(), fftBuffer.begin() + spectrumSize, delayLine.begin() + delayLinePosition * spectrumSize);
+
+    std::fill(accumulator.begin(), accumulator.end(), 0.0f);
+
+    //partition p lines up with the input block from p blocks ago
+    for (int partition = 0; partition < numPartitions; ++partition)
+    {
+        auto gain = partitionGains != nullptr ? partitionGains[partition] : 1.0f;
+
+        if (gain <= 0.0f)
+            continue;
+
+        auto slot = delayLinePosition - partition;
+
+        if (slot < 0)
+            slot += numPartitions;
+
+        auto* x     = delayLine.data() + slot * spectrumSize;
+        auto* h     = impulse->spectra.data() + partition * spectrumSize;
+        auto* acc   = accumulator.data();
+
+        for (int bin = 0; bin < spectrumSize; bin += 2)
+        {
+            auto re = x[bin] * h[bin]     - x[bin + 1] * h[bin + 1];
+            auto im = x[bin] * h[bin + 1] + x[bin + 1] * h[bin];
+
+            acc[bin]     += re * gain;
+            acc[bin + 1] += im * gain;
+        }
+    }
+
+    if (++delayLinePosition == numPartitions)
+        delayLinePosition = 0;
+
+    std::copy(accumulator.begin(), accumulator.end(), fftBuffer.begin());
+    std::fill(fftBuffer.begin() + spectrumSize, fftBuffer.end(), 0.0f);
+    fft->performRealOnlyInverseTransform(fftBuffer.data());
+
+    //the first half wrapped around, the second half is the block
+    std::copy(fftBuffer.begin() + blockSize, fftBuffer.begin() + fftSize, output);
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//an impulse response segment cut into partitions of blockSize samples, each one already turned into a spectrum,
+//it's read only once it's built so any number of convolvers (in any number of plugin instances) can share one
+struct PartitionedImpulse
+{
+    PartitionedImpulse(const float* impulse, int impulseLength, int blockSize);
+
+    int blockSize       = 0;
+    int numBins         = 0;
+    int numPartitions   = 0;
+
+    //numPartitions spectra of numBins complex values, interleaved real/imaginary
+    std::vector<float> spectra;
+
+    size_t getSizeInBytes() const noexcept { return spectra.size() * sizeof(float); }
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PartitionedImpulse)
+};
+
+/*uniformly partitioned overlap-save convolution of one channel with one impulse response segment
+
+every processed block goes through one fft, gets multiplied with every partition against the block it lines up with
+from the frequency domain delay line, and comes back through one inverse fft
+
+output is one block late, process() gets exactly blockSize samples in and gives blockSize samples out*/
+class PartitionedConvolver
+{
+public:
+    PartitionedConvolver();
+    ~PartitionedConvolver();
+
+    //allocates the input side for the impulse, not for the audio thread
+    void prepare(std::shared_ptr<const PartitionedImpulse> newImpulse);
+
+    void reset();
+
+    //partitionGains holds one gain per partition, partitions with a gain of 0 are skipped, nullptr plays them all at 1
+    void process(const float* input, float* output, const float* partitionGains = nullptr) noexcept;
+
+    int getBlockSize() const noexcept     { return blockSize; }
+    int getNumPartitions() const noexcept { return numPartitions; }
+
+    //the input side prepare allocated, the impulse is shared and isn't counted
+    size_t getSizeInBytes() const noexcept
+    {
+        return (delayLine.size() + inputFrame.size() + fftBuffer.size() + accumulator.size()) * sizeof(float);
+    }
+
+private:
+    std::unique_ptr<juce::dsp::FFT> fft;
+    std::shared_ptr<const PartitionedImpulse> impulse;
+
+    int blockSize       = 0;
+    int fftSize         = 0;
+    int numBins         = 0;
+    int numPartitions   = 0;
+
+    std::vector<float> delayLine;           //numPartitions spectra of the past input blocks
+    int delayLinePosition = 0;
+
+    std::vector<float> inputFrame;          //the last two input blocks
+    std::vector<float> fftBuffer;           //2 * fftSize, what the fft works in place on
+    std::vector<float> accumulator;         //numBins complex values
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PartitionedConvolver)
+};
@@ -25,7 +25,7 @@ juce::Rectangle<int> LookAndFeel::getSliderBounds(juce::Slider& slider)
 juce::String LookAndFeel::getDisplayString(juce::Slider& slider)
 {
     //boolean to check if the slider is the distortion type slider
-    juce::Range<double> typeRange = { 0 , 6 };
+    juce::Range<double> typeRange = { 0 , 7 };
     bool checkIfDistTypeSlider = slider.getRange() == typeRange;
 
     juce::String str;
@@ -83,6 +83,11 @@ juce::String LookAndFeel::getDisplayString(juce::Slider& slider)
                     str = "Bypass";
                     break;
                 }
+                case 7:
+                {
+                    str = "Custom";
+                    break;
+                }
             }
             break;
         }
@@ -106,7 +111,7 @@ juce::String LookAndFeel::getDisplayString(juce::Slider& slider)
 void LookAndFeel::drawRotarySlider(juce::Graphics& g, float rotaryStartAngle, float rotaryEndAngle, juce::Slider& slider)
 {
     //check if the slider is the distortion type slider
-    juce::Range<double> typeRange = { 0, 6 };
+    juce::Range<double> typeRange = { 0, 7 };
     bool checkIfDistTypeSlider = slider.getRange() == typeRange;
 
     //turn the slider that juce draws invisible
@@ -125,11 +130,12 @@ void LookAndFeel::drawRotarySlider(juce::Graphics& g, float rotaryStartAngle, fl
     auto bounds = juce::Rectangle<float>(x, y, width, height);
 
     //set the color of the inside of the knob
-    g.setColour(juce::Colour(80u, 80u, 80u));
+    g.setColour(slider.isEnabled() ? juce::Colour(80u, 80u, 80u) : juce::Colour(60u, 60u, 60u));
     g.fillEllipse(bounds);
 
     //uint knobColor = juce::jlimit(0, 255, (int)(slider.getValue() * 2.55));
-    uint knobColor = 255;
+    //greyed out while the Morph knob has taken over
+    uint knobColor = slider.isEnabled() ? 255 : 130;
     g.setColour(juce::Colour(knobColor, knobColor, knobColor));
     g.drawEllipse(bounds, 3.f);
 
@@ -200,7 +206,7 @@ void LookAndFeel::drawRotarySlider(juce::Graphics& g, float rotaryStartAngle, fl
 //useless function
 void LookAndFeel::drawTypeText(juce::Graphics& g, juce::Slider& slider)
 {
-    juce::Range<double> bruh = { 0, 6 };
+    juce::Range<double> bruh = { 0, 7 };
 
     auto text = LookAndFeel::getDisplayString(slider);
     auto strWidth = g.getCurrentFont().getStringWidth(text);
@@ -293,6 +299,147 @@ void SpinningObject::resized()
 
 }
 
+TransferCurveComponent::TransferCurveComponent(RealMagiVerbAudioProcessor& p) : audioProcessor(p)
+{
+    curve = audioProcessor.getTransferCurve();
+    version = audioProcessor.getTransferCurveVersion();
+}
+
+void TransferCurveComponent::refresh()
+{
+    //not in the middle of a drag, the point being dragged could disappear
+    if (dragIndex >= 0 || version == audioProcessor.getTransferCurveVersion())
+        return;
+
+    curve = audioProcessor.getTransferCurve();
+    version = audioProcessor.getTransferCurveVersion();
+    repaint();
+}
+
+juce::Point<float> TransferCurveComponent::toCurve(juce::Point<float> position) const
+{
+    auto bounds = getLocalBounds().toFloat().reduced(4.0f);
+
+    return { juce::jmap(position.x, bounds.getX(), bounds.getRight(), -1.0f, 1.0f),
+             juce::jmap(position.y, bounds.getBottom(), bounds.getY(), -1.0f, 1.0f) };
+}
+
+juce::Point<float> TransferCurveComponent::toScreen(juce::Point<float> point) const
+{
+    auto bounds = getLocalBounds().toFloat().reduced(4.0f);
+
+    return { juce::jmap(point.x, -1.0f, 1.0f, bounds.getX(), bounds.getRight()),
+             juce::jmap(point.y, -1.0f, 1.0f, bounds.getBottom(), bounds.getY()) };
+}
+
+int TransferCurveComponent::findPoint(juce::Point<float> position) const
+{
+    for (size_t i = 0; i < curve.points.size(); ++i)
+        if (toScreen(curve.points[i]).getDistanceFrom(position) < 6.0f)
+            return (int) i;
+
+    return -1;
+}
+
+void TransferCurveComponent::curveChanged()
+{
+    audioProcessor.setTransferCurve(curve);
+    version = audioProcessor.getTransferCurveVersion();
+    repaint();
+}
+
+void TransferCurveComponent::paint(juce::Graphics& g)
+{
+    auto bounds = getLocalBounds().toFloat();
+
+    g.setColour(juce::Colour(40u, 40u, 40u));
+    g.fillRoundedRectangle(bounds, 6.0f);
+
+    //the zero lines
+    g.setColour(juce::Colour(90u, 90u, 90u));
+    g.drawHorizontalLine((int) bounds.getCentreY(), bounds.getX(), bounds.getRight());
+    g.drawVerticalLine((int) bounds.getCentreX(), bounds.getY(), bounds.getBottom());
+
+    //the spline itself, a point every other pixel is plenty
+    juce::Path path;
+
+    for (int x = 0; x <= getWidth(); x += 2)
+    {
+        auto input = toCurve({ (float) x, 0.0f }).x;
+        auto point = toScreen({ input, curve.evaluate(input) });
+
+        if (x == 0)
+            path.startNewSubPath(point);
+        else
+            path.lineTo(point);
+    }
+
+    g.setColour(juce::Colours::white);
+    g.strokePath(path, juce::PathStrokeType(2.0f));
+
+    for (auto& point : curve.points)
+    {
+        auto centre = toScreen(point);
+        g.fillEllipse(centre.x - 3.5f, centre.y - 3.5f, 7.0f, 7.0f);
+    }
+}
+
+void TransferCurveComponent::mouseDown(const juce::MouseEvent& event)
+{
+    auto position = event.position;
+    dragIndex = findPoint(position);
+
+    if (dragIndex >= 0 || (int) curve.points.size() >= TransferCurve::maxPoints)
+        return;
+
+    //a new point where the click was, kept in order so the indexes stay sorted by x
+    auto point = toCurve(position);
+    point.x = juce::jlimit(-0.99f, 0.99f, point.x);
+    point.y = juce::jlimit(-1.0f, 1.0f, point.y);
+
+    auto after = std::upper_bound(curve.points.begin(), curve.points.end(), point,
+        [](juce::Point<float> a, juce::Point<float> b) { return a.x < b.x; });
+
+    dragIndex = (int) std::distance(curve.points.begin(), curve.points.insert(after, point));
+    curveChanged();
+}
+
+void TransferCurveComponent::mouseDrag(const juce::MouseEvent& event)
+{
+    if (dragIndex < 0)
+        return;
+
+    auto point = toCurve(event.position);
+    auto& dragged = curve.points[(size_t) dragIndex];
+    auto last = (int) curve.points.size() - 1;
+
+    //the ends only move up and down, the rest stay between their neighbours
+    if (dragIndex > 0 && dragIndex < last)
+        dragged.x = juce::jlimit(curve.points[(size_t) dragIndex - 1].x + 0.01f,
+                                 curve.points[(size_t) dragIndex + 1].x - 0.01f, point.x);
+
+    dragged.y = juce::jlimit(-1.0f, 1.0f, point.y);
+    curveChanged();
+}
+
+void TransferCurveComponent::mouseUp(const juce::MouseEvent&)
+{
+    dragIndex = -1;
+}
+
+void TransferCurveComponent::mouseDoubleClick(const juce::MouseEvent& event)
+{
+    auto index = findPoint(event.position);
+
+    //the two ends always stay
+    if (index > 0 && index < (int) curve.points.size() - 1)
+    {
+        curve.points.erase(curve.points.begin() + index);
+        dragIndex = -1;
+        curveChanged();
+    }
+}
+
 //debug function
 void drawElipse(juce::Graphics& g, juce::Slider& slider)
 {
@@ -320,7 +467,7 @@ void RealMagiVerbAudioProcessorEditor::drawLabel(juce::String text, juce::Label&
     
 //==============================================================================
 RealMagiVerbAudioProcessorEditor::RealMagiVerbAudioProcessorEditor (RealMagiVerbAudioProcessor& p)
-    : AudioProcessorEditor (&p), audioProcessor (p), spinningObject(audioProcessor)
+    : AudioProcessorEditor (&p), audioProcessor (p), spinningObject(audioProcessor), transferCurveComponent(p)
 {
     // Make sure that before the constructor has finished, you've set the
     // editor's size to whatever you need it to be
@@ -374,9 +521,59 @@ RealMagiVerbAudioProcessorEditor::RealMagiVerbAudioProcessorEditor (RealMagiVerb
         entropySlAtt            = std::make_unique<Attachment>(*apvts.getParameter("Entropy"), entropySlider);
     }
 
+    //morph strip
+    {
+        morphSlider.setSliderStyle(juce::Slider::LinearHorizontal);
+        morphSlider.setTextBoxStyle(juce::Slider::NoTextBox, true, 0, 0);
+        morphSliderAtt = std::make_unique<Attachment>(*apvts.getParameter("Morph"), morphSlider);
+
+        storeAButton.onClick        = [this]() { audioProcessor.storeMorphSnapshot(0); updateMorphButtons(); };
+        storeBButton.onClick        = [this]() { audioProcessor.storeMorphSnapshot(1); updateMorphButtons(); };
+        clearMorphButton.onClick    = [this]() { audioProcessor.clearMorphSnapshots(); updateMorphButtons(); };
+
+        addAndMakeVisible(morphSlider);
+        addAndMakeVisible(storeAButton);
+        addAndMakeVisible(storeBButton);
+        addAndMakeVisible(clearMorphButton);
+
+        updateMorphButtons();
+    }
+
+    //reverb engine strip
+    {
+        if (auto* modeParameter = dynamic_cast<juce::AudioParameterChoice*>(apvts.getParameter("Reverb Mode")))
+            reverbModeBox.addItemList(modeParameter->choices, 1);
+
+        reverbModeBoxAtt = std::make_unique<juce::ComboBoxParameterAttachment>(*apvts.getParameter("Reverb Mode"), reverbModeBox);
+
+        loadImpulseButton.onClick = [this]() { chooseImpulseResponse(); };
+
+        auto impulseFile = audioProcessor.getImpulseResponseFile();
+        impulseNameLabel.setText(impulseFile == juce::File() ? "No IR" : impulseFile.getFileNameWithoutExtension(), juce::dontSendNotification);
+        impulseNameLabel.setJustificationType(juce::Justification::centredLeft);
+
+        addAndMakeVisible(reverbModeBox);
+        addAndMakeVisible(loadImpulseButton);
+        addAndMakeVisible(impulseNameLabel);
+    }
+
+    addAndMakeVisible(transferCurveComponent);
+
+    //preset strip
+    {
+        presetNameEditor.setTextToShowWhenEmpty("Preset name", juce::Colours::grey);
+        presetNameEditor.onReturnKey = [this]() { savePreset(); };
+        savePresetButton.onClick = [this]() { savePreset(); };
+
+        addAndMakeVisible(presetNameEditor);
+        addAndMakeVisible(savePresetButton);
+    }
+
     setResizable(false, false);
 
-    setSize (400, 570);
+    setSize (400, 845);
+
+    startTimerHz(10);
 }
 
 RealMagiVerbAudioProcessorEditor::~RealMagiVerbAudioProcessorEditor()
@@ -416,6 +613,10 @@ void RealMagiVerbAudioProcessorEditor::paint (juce::Graphics& g)
         juce::Rectangle<float> modRect      = { 270, 30, 110, 200 };
         juce::Rectangle<float> distRect     = { 30, 270, 200, 200 };
         juce::Rectangle<float> filterRect   = { 270, 270, 110, 200 };
+        juce::Rectangle<float> morphRect    = { 30, 580, 350, 55 };
+        juce::Rectangle<float> impulseRect  = { 30, 645, 350, 45 };
+        juce::Rectangle<float> curveRect    = { 30, 697, 350, 96 };
+        juce::Rectangle<float> presetRect   = { 30, 800, 350, 42 };
 
         g.setColour(juce::Colours::white);
         g.drawRoundedRectangle(reverbRect, 8.0f, 4.0f);
@@ -440,6 +641,34 @@ void RealMagiVerbAudioProcessorEditor::paint (juce::Graphics& g)
         filterRectPath.addRoundedRectangle(filterRect.reduced(2), 8.0);
         g.setColour(juce::Colour(80u, 80u, 80u));
         g.fillPath(filterRectPath);
+
+        juce::Path morphRectPath;
+        g.setColour(juce::Colours::white);
+        g.drawRoundedRectangle(morphRect, 8.0f, 4.0f);
+        morphRectPath.addRoundedRectangle(morphRect.reduced(2), 8.0);
+        g.setColour(juce::Colour(70u, 70u, 70u));
+        g.fillPath(morphRectPath);
+
+        juce::Path impulseRectPath;
+        g.setColour(juce::Colours::white);
+        g.drawRoundedRectangle(impulseRect, 8.0f, 4.0f);
+        impulseRectPath.addRoundedRectangle(impulseRect.reduced(2), 8.0);
+        g.setColour(juce::Colour(60u, 60u, 60u));
+        g.fillPath(impulseRectPath);
+
+        juce::Path curveRectPath;
+        g.setColour(juce::Colours::white);
+        g.drawRoundedRectangle(curveRect, 8.0f, 4.0f);
+        curveRectPath.addRoundedRectangle(curveRect.reduced(2), 8.0);
+        g.setColour(juce::Colour(50u, 50u, 50u));
+        g.fillPath(curveRectPath);
+
+        juce::Path presetRectPath;
+        g.setColour(juce::Colours::white);
+        g.drawRoundedRectangle(presetRect, 8.0f, 4.0f);
+        presetRectPath.addRoundedRectangle(presetRect.reduced(2), 8.0);
+        g.setColour(juce::Colour(40u, 40u, 40u));
+        g.fillPath(presetRectPath);
     }
     
     //more manual code because I still can't use god damn templates
@@ -540,6 +769,70 @@ void RealMagiVerbAudioProcessorEditor::resized()
     setLabelBounds(entropyBounds, entropyLabel);
 
     spinButton.setBounds(5, 0, 35, 35);
+
+    storeAButton.setBounds(storeABounds);
+    storeBButton.setBounds(storeBBounds);
+    morphSlider.setBounds(morphBounds);
+    clearMorphButton.setBounds(clearMorphBounds);
+
+    reverbModeBox.setBounds(reverbModeBounds);
+    loadImpulseButton.setBounds(loadImpulseBounds);
+    impulseNameLabel.setBounds(impulseNameBounds);
+
+    transferCurveComponent.setBounds(transferCurveBounds);
+
+    presetNameEditor.setBounds(presetNameBounds);
+    savePresetButton.setBounds(savePresetBounds);
+}
+
+void RealMagiVerbAudioProcessorEditor::savePreset()
+{
+    if (audioProcessor.savePreset(presetNameEditor.getText().trim()))
+        presetNameEditor.clear();
+}
+
+void RealMagiVerbAudioProcessorEditor::chooseImpulseResponse()
+{
+    impulseChooser = std::make_unique<juce::FileChooser>("Load an impulse response",
+        audioProcessor.getImpulseResponseFile(), "*.wav;*.aif;*.aiff;*.flac");
+
+    auto flags = juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles;
+
+    impulseChooser->launchAsync(flags, [this](const juce::FileChooser& chooser)
+    {
+        auto file = chooser.getResult();
+
+        if (file.existsAsFile() && audioProcessor.loadImpulseResponse(file))
+            impulseNameLabel.setText(file.getFileNameWithoutExtension(), juce::dontSendNotification);
+    });
+}
+
+void RealMagiVerbAudioProcessorEditor::updateMorphButtons()
+{
+    auto hasA = audioProcessor.hasMorphSnapshot(0);
+    auto hasB = audioProcessor.hasMorphSnapshot(1);
+
+    storeAButton.setToggleState(hasA, juce::dontSendNotification);
+    storeBButton.setToggleState(hasB, juce::dontSendNotification);
+
+    //with both stored the knobs don't do anything, they stay where they are but can't be turned
+    morphingShown = hasA && hasB;
+
+    for (auto* comp : getComps())
+        comp->setEnabled(! morphingShown);
+
+    clearMorphButton.setButtonText(morphingShown ? "Unlock" : "Clear");
+    repaint();
+}
+
+void RealMagiVerbAudioProcessorEditor::timerCallback()
+{
+    transferCurveComponent.refresh();
+
+    if ((audioProcessor.hasMorphSnapshot(0) && audioProcessor.hasMorphSnapshot(1)) != morphingShown
+        || storeAButton.getToggleState() != audioProcessor.hasMorphSnapshot(0)
+        || storeBButton.getToggleState() != audioProcessor.hasMorphSnapshot(1))
+        updateMorphButtons();
 }
 
 std::vector<juce::Component*> RealMagiVerbAudioProcessorEditor::getComps()
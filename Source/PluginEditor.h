@@ -35,8 +35,44 @@ struct SpinningObject : public juce::Component, public juce::Timer
     RealMagiVerbAudioProcessor& audioProcessor;
 };
 
+//the curve of the Custom distortion type, click to add a point, drag to move one and double click to remove it
+struct TransferCurveComponent : public juce::Component
+{
+    TransferCurveComponent(RealMagiVerbAudioProcessor& p);
+
+    void paint(juce::Graphics& g) override;
+    void mouseDown(const juce::MouseEvent& event) override;
+    void mouseDrag(const juce::MouseEvent& event) override;
+    void mouseUp(const juce::MouseEvent& event) override;
+    void mouseDoubleClick(const juce::MouseEvent& event) override;
+
+    RealMagiVerbAudioProcessor& audioProcessor;
+
+    //the editor's copy, every change goes straight to the processor
+    TransferCurve curve;
+
+    //the point being dragged, -1 if none
+    int dragIndex = -1;
+
+    //picks the processor's curve up again if something other than this component changed it
+    void refresh();
+
+private:
+    //between the component's pixels and the curve's [-1, 1] box
+    juce::Point<float> toCurve(juce::Point<float> position) const;
+    juce::Point<float> toScreen(juce::Point<float> point) const;
+
+    //the point under the mouse, -1 if none
+    int findPoint(juce::Point<float> position) const;
+
+    void curveChanged();
+
+    //the processor's curve version this copy is of
+    int version = 0;
+};
+
 //==============================================================================
-class RealMagiVerbAudioProcessorEditor  : public juce::AudioProcessorEditor, juce::Button::Listener
+class RealMagiVerbAudioProcessorEditor  : public juce::AudioProcessorEditor, juce::Button::Listener, juce::Timer
 {
 public:
     RealMagiVerbAudioProcessorEditor (RealMagiVerbAudioProcessor&);
@@ -113,6 +149,53 @@ private:
     juce::Rectangle<int> postGainBounds     = { 145, 480, 70, 70 };
     juce::Rectangle<int> entropyBounds      = { 290, 480, 70, 70 };
 
+    //the morph strip along the bottom, A and B store the current sound in that slot
+    juce::Slider morphSlider;
+    juce::TextButton storeAButton{ "A" }, storeBButton{ "B" }, clearMorphButton{ "Clear" };
+    std::unique_ptr<juce::SliderParameterAttachment> morphSliderAtt;
+
+    juce::Rectangle<int> storeABounds       = { 40, 592, 35, 30 };
+    juce::Rectangle<int> storeBBounds       = { 80, 592, 35, 30 };
+    juce::Rectangle<int> morphBounds        = { 125, 592, 180, 30 };
+    juce::Rectangle<int> clearMorphBounds   = { 310, 592, 60, 30 };
+
+    //lights up the A and B buttons that have a snapshot in them, and greys out the knobs the Morph knob overrides
+    //while both are stored
+    void updateMorphButtons();
+    bool morphingShown = false;
+
+    //picks up what changed without the editor, a loaded session or preset
+    void timerCallback() override;
+
+    //the reverb engine strip under that, mode and the impulse response for the convolution one
+    juce::ComboBox reverbModeBox;
+    juce::TextButton loadImpulseButton{ "Load IR" };
+    juce::Label impulseNameLabel;
+    std::unique_ptr<juce::ComboBoxParameterAttachment> reverbModeBoxAtt;
+    std::unique_ptr<juce::FileChooser> impulseChooser;
+
+    juce::Rectangle<int> reverbModeBounds   = { 40, 652, 120, 30 };
+    juce::Rectangle<int> loadImpulseBounds  = { 165, 652, 70, 30 };
+    juce::Rectangle<int> impulseNameBounds  = { 240, 652, 130, 30 };
+
+    //opens the file chooser and hands whatever got picked to the processor
+    void chooseImpulseResponse();
+
+    //the Custom distortion curve along the very bottom
+    TransferCurveComponent transferCurveComponent;
+
+    juce::Rectangle<int> transferCurveBounds = { 40, 705, 330, 80 };
+
+    //the preset strip under everything, saves the whole sound into the bank behind the host's program list
+    juce::TextEditor presetNameEditor;
+    juce::TextButton savePresetButton{ "Save Preset" };
+
+    juce::Rectangle<int> presetNameBounds   = { 40, 807, 230, 28 };
+    juce::Rectangle<int> savePresetBounds   = { 280, 807, 90, 28 };
+
+    //adds the current sound to the bank under whatever name is typed in
+    void savePreset();
+
 
     // This reference is provided as a quick way for your editor to
     // access the processor object that created it.
@@ -1,9 +1,17 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include "PluginState.h"
+#include "Distortion.h"
 
-const float PI = 3.1415926535f;
 const float oneOverSQ2 = 1 / sqrt(2);
 
+//a juce delay line keeps one sample more than its longest delay for every channel
+template <typename DelayLineType>
+static size_t getDelaySizeInBytes(const DelayLineType& delay, int numChannels)
+{
+    return (size_t) (delay.getMaximumDelayInSamples() + 1) * (size_t) numChannels * sizeof(float);
+}
+
 //==============================================================================
 RealMagiVerbAudioProcessor::RealMagiVerbAudioProcessor()
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -11,6 +19,7 @@ RealMagiVerbAudioProcessor::RealMagiVerbAudioProcessor()
                      #if ! JucePlugin_IsMidiEffect
                       #if ! JucePlugin_IsSynth
                        .withInput  ("Input",  juce::AudioChannelSet::stereo(), true)
+                       .withInput  ("Sidechain", juce::AudioChannelSet::stereo(), false)
                       #endif
                        .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
                      #endif
@@ -18,34 +27,71 @@ RealMagiVerbAudioProcessor::RealMagiVerbAudioProcessor()
                        , lowCutFilter(1), highCutFilter(2)
 #endif
 {
-    apvts.addParameterListener("Reverb Size", this);
-    apvts.addParameterListener("Reverb Damping", this);
-    apvts.addParameterListener("Reverb Width", this);
-    apvts.addParameterListener("Reverb Dry/Wet", this);
-    apvts.addParameterListener("Modulation Rate", this);
-    apvts.addParameterListener("Modulation Amount", this);
-    apvts.addParameterListener("Distortion Gain", this);
-    apvts.addParameterListener("Distortion Type", this);
-    apvts.addParameterListener("Rate Divide", this);
-    apvts.addParameterListener("Bit Depth", this);
-    apvts.addParameterListener("Pre-Gain", this);
-    apvts.addParameterListener("Post-Gain", this);
+    //only the parameters parameterChanged does something with, everything else is read once per block
+    apvts.addParameterListener("Chain Order", this);
+    apvts.addParameterListener("Oversampling", this);
+    apvts.addParameterListener("Anti-Aliasing", this);
+    apvts.addParameterListener("Reduced Rate", this);
+    apvts.addParameterListener("Reverb Mode", this);
+    apvts.addParameterListener("Quality Mode", this);
+    apvts.addParameterListener("Output Limiter", this);
+
+    rawParameters = getRawSoundParameters(apvts);
+    soundParameters = getSoundParameters(apvts);
+    buildPresetLayout();
+    activeChainOrder.store((int) apvts.getRawParameterValue("Chain Order")->load());
+    morphParameter = apvts.getRawParameterValue("Morph");
+
+    distortionMix       = apvts.getRawParameterValue("Distortion Mix");
+    crushMix            = apvts.getRawParameterValue("Crush Mix");
+    ditherMode          = apvts.getRawParameterValue("Dither");
+    oversamplingChoice  = apvts.getRawParameterValue("Oversampling");
+    shaperQuality       = apvts.getRawParameterValue("Shaper Quality");
+    antiAliasing        = apvts.getRawParameterValue("Anti-Aliasing");
+    qualityMode         = apvts.getRawParameterValue("Quality Mode");
+
+    chorusRouting       = apvts.getRawParameterValue("Chorus Routing");
+    chorusVoices        = apvts.getRawParameterValue("Chorus Voices");
+    chorusInterpolation = apvts.getRawParameterValue("Chorus Interpolation");
+    chorusFeedback      = apvts.getRawParameterValue("Chorus Feedback");
+    chorusDelay         = apvts.getRawParameterValue("Chorus Delay");
+    driveRouting        = apvts.getRawParameterValue("Distortion Routing");
+    reverbRouting       = apvts.getRawParameterValue("Reverb Routing");
+    reverbMode          = apvts.getRawParameterValue("Reverb Mode");
+    parallelDsp         = apvts.getRawParameterValue("Parallel DSP");
+    reducedRate         = apvts.getRawParameterValue("Reduced Rate");
+    modulationSync      = apvts.getRawParameterValue("Modulation Sync");
+    syncDivision        = apvts.getRawParameterValue("Sync Division");
+    crushGate           = apvts.getRawParameterValue("Crush Gate");
+
+    sidechainDuck       = apvts.getRawParameterValue("Sidechain Duck");
+    sidechainDrive      = apvts.getRawParameterValue("Sidechain Drive");
+    sidechainAttack     = apvts.getRawParameterValue("Sidechain Attack");
+    sidechainRelease    = apvts.getRawParameterValue("Sidechain Release");
+    autoGainEnabled     = apvts.getRawParameterValue("Auto Gain");
+    limiterEnabled      = apvts.getRawParameterValue("Output Limiter");
+    limiterCeiling      = apvts.getRawParameterValue("Limiter Ceiling");
+
+    //the shaper tables get filled here so the audio thread never has to, they're shared so only the first
+    //instance pays for it, the Custom curve waits for prepareToPlay or a loaded state
+    ShapingFunctions::initialise();
+
+    for (auto& value : pendingSnapshot)
+        value.store(0.0f);
 }
 
 RealMagiVerbAudioProcessor::~RealMagiVerbAudioProcessor()
 {
-    apvts.removeParameterListener("Reverb Size", this);
-    apvts.removeParameterListener("Reverb Damping", this);
-    apvts.removeParameterListener("Reverb Width", this);
-    apvts.removeParameterListener("Reverb Dry/Wet", this);
-    apvts.removeParameterListener("Modulation Rate", this);
-    apvts.removeParameterListener("Modulation Amount", this);
-    apvts.removeParameterListener("Distortion Gain", this);
-    apvts.removeParameterListener("Distortion Choice", this);
-    apvts.removeParameterListener("Rate Divide", this);
-    apvts.removeParameterListener("Bit Depth", this);
-    apvts.removeParameterListener("Pre-Gain", this);
-    apvts.removeParameterListener("Post-Gain", this);
+    stopTimer();
+    cancelPendingUpdate();
+
+    apvts.removeParameterListener("Chain Order", this);
+    apvts.removeParameterListener("Oversampling", this);
+    apvts.removeParameterListener("Anti-Aliasing", this);
+    apvts.removeParameterListener("Reduced Rate", this);
+    apvts.removeParameterListener("Reverb Mode", this);
+    apvts.removeParameterListener("Quality Mode", this);
+    apvts.removeParameterListener("Output Limiter", this);
 }
 
 //==============================================================================
@@ -84,280 +130,1458 @@ bool RealMagiVerbAudioProcessor::isMidiEffect() const
 
 double RealMagiVerbAudioProcessor::getTailLengthSeconds() const
 {
-    return 0.0;
+    auto size = rawParameters[(size_t) SoundParam::revSize]->load() / 100;
+
+    //the same mapping processChunk gives the convolution reverb, Size is how much of the impulse plays and Width
+    //is the predelay, without an impulse the algorithmic one stands in
+    auto impulseSeconds = convolutionReverb.getImpulseLengthSeconds();
+
+    if (reverbMode->load() > 0.5f && impulseSeconds > 0.0)
+        return impulseSeconds * juce::jmap(size, 0.2f, 1.0f)
+             + rawParameters[(size_t) SoundParam::revWidth]->load() / 100 * ConvolutionReverb::maxPredelayMs / 1000.0;
+
+    return ReverbEngines::getDecaySeconds(size);
+}
+
+PresetBank& RealMagiVerbAudioProcessor::getPresetBank()
+{
+    //mapped the first time the host asks about programs, not while it's scanning
+    if (! presetBankOpened)
+    {
+        presetBank.open(PresetBank::getDefaultFolder());
+        presetBankOpened = true;
+    }
+
+    return presetBank;
 }
 
 int RealMagiVerbAudioProcessor::getNumPrograms()
 {
-    return 1;   // NB: some hosts don't cope very well if you tell them there are 0 programs,
-                // so this should be at least 1, even if you're not really implementing programs.
+    //some hosts don't cope very well if you tell them there are 0 programs, so without a bank there's still "Init"
+    return juce::jmax(1, getPresetBank().getNumPresets());
 }
 
 int RealMagiVerbAudioProcessor::getCurrentProgram()
 {
-    return 0;
+    return currentProgram;
 }
 
 void RealMagiVerbAudioProcessor::setCurrentProgram (int index)
 {
+    if (getPresetBank().getNumPresets() == 0)
+    {
+        currentProgram = 0;
+        applyPreset(defaultPreset);
+        return;
+    }
+
+    std::vector<float> values;
+
+    if (getPresetBank().getPreset(index, values))
+    {
+        currentProgram = index;
+        applyPreset(values);
+    }
+}
+
+const juce::String RealMagiVerbAudioProcessor::getProgramName (int index)
+{
+    if (getPresetBank().getNumPresets() == 0)
+        return index == 0 ? juce::String("Init") : juce::String();
+
+    return getPresetBank().getPresetName(index);
+}
+
+void RealMagiVerbAudioProcessor::changeProgramName (int index, const juce::String& newName)
+{
+    if (getPresetBank().renamePreset(index, newName))
+        updateHostDisplay();
+}
+
+bool RealMagiVerbAudioProcessor::savePreset(const juce::String& name)
+{
+    auto index = getPresetBank().getNumPresets();
+
+    if (! getPresetBank().addPreset(name.isNotEmpty() ? name : "Preset " + juce::String(index + 1), getPresetValues()))
+        return false;
+
+    //the bank could have moved to a newer generation with more presets in it first, the new one is always last
+    currentProgram = getPresetBank().getNumPresets() - 1;
+    updateHostDisplay();
+    return true;
+}
+
+void RealMagiVerbAudioProcessor::buildPresetLayout()
+{
+    juce::StringArray ids;
+
+    for (auto* parameter : getParameters())
+    {
+        if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameter))
+        {
+            ids.add(ranged->paramID);
+            layoutParameters.push_back(ranged);
+            defaultPreset.push_back(ranged->convertFrom0to1(ranged->getDefaultValue()));
+        }
+    }
+
+    for (int i = 0; i < numSoundParams; ++i)
+        soundParamIndices[(size_t) i] = ids.indexOf(soundParamIDs[i]);
+
+    for (int i = 0; i < ids.size(); ++i)
+        if (std::find(soundParamIndices.begin(), soundParamIndices.end(), i) == soundParamIndices.end())
+            otherParamIndices.push_back(i);
+
+    presetBank.setLayout(ids);
+    presetBank.onChange = [this] { updateHostDisplay(); };
+}
+
+juce::NamedValueSet RealMagiVerbAudioProcessor::getPresetValues()
+{
+    juce::NamedValueSet values;
+
+    for (auto* parameter : layoutParameters)
+        values.set(parameter->paramID, parameter->convertFrom0to1(parameter->getValue()));
+
+    return values;
+}
+
+void RealMagiVerbAudioProcessor::applyPreset(const std::vector<float>& values)
+{
+    //the sound parameters go through a snapshot so the audio thread never blends half of one preset with the last,
+    //the ones the preset doesn't have keep their values
+    ParameterSnapshot snapshot;
+    snapshot.capture(rawParameters);
+
+    for (size_t i = 0; i < soundParamIndices.size(); ++i)
+        if (soundParamIndices[i] >= 0 && std::isfinite(values[(size_t) soundParamIndices[i]]))
+            snapshot.values[i] = values[(size_t) soundParamIndices[i]];
+
+    //everything else is set one by one, none of it is blended, and only what the preset changes reaches the host
+    for (auto index : otherParamIndices)
+    {
+        auto* parameter = layoutParameters[(size_t) index];
+        auto value = values[(size_t) index];
+
+        if (! std::isfinite(value))
+            continue;
+
+        auto normalised = parameter->convertTo0to1(value);
+
+        if (normalised != parameter->getValue())
+            parameter->setValueNotifyingHost(normalised);
+    }
+
+    applySnapshot(snapshot);
+}
+
+void RealMagiVerbAudioProcessor::applySnapshot(const ParameterSnapshot& snapshot)
+{
+    for (size_t i = 0; i < pendingSnapshot.size(); ++i)
+        pendingSnapshot[i].store(snapshot.values[i], std::memory_order_relaxed);
+
+    snapshotCounter.fetch_add(1, std::memory_order_release);
+    snapshot.applyTo(soundParameters);
+    snapshotCounter.fetch_add(1, std::memory_order_release);
+}
+
+void RealMagiVerbAudioProcessor::readParameters(ParameterSnapshot& params)
+{
+    //seqlock style read, if a snapshot started or finished being applied while we were reading, read again
+    for (int attempt = 0; attempt < 3; ++attempt)
+    {
+        auto before = snapshotCounter.load(std::memory_order_acquire);
+
+        if ((before & 1u) != 0)
+        {
+            for (size_t i = 0; i < pendingSnapshot.size(); ++i)
+                params.values[i] = pendingSnapshot[i].load(std::memory_order_relaxed);
+        }
+        else
+        {
+            params.capture(rawParameters);
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        if (snapshotCounter.load(std::memory_order_relaxed) == before)
+            return;
+    }
+}
+
+//==============================================================================
+void RealMagiVerbAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
+{
+    // Use this method as the place to do any pre-playback
+    // initialisation that you need..
+
+    //the widest version of the vectorised loops this cpu can run
+    DspKernels::select();
+
+    juce::dsp::ProcessSpec filterSpec;
+
+    filterSpec.sampleRate       = sampleRate;
+    filterSpec.maximumBlockSize = samplesPerBlock;
+    filterSpec.numChannels      = 2;
+
+    convolutionReverb.prepare({ sampleRate, (juce::uint32) juce::jmin(controlBlockSize, samplesPerBlock), 2 });
+
+    //the low rate versions only get prepared at rates Reduced Rate would actually bring down
+    reducedFactor = RateReducer::getFactorForRate(sampleRate);
+
+    //whatever engines there were are for the old rate, only the stages that are turned up right now get new ones,
+    //the others are built once the audio thread asks for them, a bounce gets both so it never waits on the message
+    //thread and comes out the same every time
+    {
+        const juce::ScopedLock lock(engineLock);
+
+        engineSampleRate = sampleRate;
+        engineBlockSize  = juce::jmin(controlBlockSize, samplesPerBlock);
+
+        clearEngines();
+
+        //the convolution reverb only needs the algorithmic one to stand in while it has no impulse
+        auto algorithmic = reverbMode->load() < 0.5f || convolutionReverb.getImpulseResponseFile() == juce::File();
+        auto offline = isNonRealtime();
+
+        buildEngines(offline || (algorithmic && apvts.getRawParameterValue("Reverb Dry/Wet")->load() > 0.0f),
+                     offline || apvts.getRawParameterValue("Modulation Amount")->load() > 0.0f);
+    }
+
+    reverbIdleSamples = 0;
+    chorusIdleSamples = 0;
+
+    arrivedReverbs = nullptr;
+    reverbArrival.reset(sampleRate, 0.02);
+    reverbArrival.setCurrentAndTargetValue(1.0f);
+
+    reverbReducer.prepare(reducedFactor, juce::jmin(controlBlockSize, samplesPerBlock), 2);
+    chorusReducer.prepare(reducedFactor, juce::jmin(controlBlockSize, samplesPerBlock), 2);
+
+    reverbDryDelay.prepare({ sampleRate, (juce::uint32) samplesPerBlock, 2 });
+    reverbDryDelay.setDelay((float) reverbReducer.getLatencyInSamples());
+    chorusDryDelay.prepare({ sampleRate, (juce::uint32) samplesPerBlock, 2 });
+    chorusDryDelay.setDelay((float) chorusReducer.getLatencyInSamples());
+
+    reverbWasReduced = chorusWasReduced = false;
+
+    lowCutFilter.prepare(filterSpec);
+    highCutFilter.prepare(filterSpec);
+
+    auto numChannels = juce::jmax(getMainBusNumInputChannels(), getMainBusNumOutputChannels());
+
+    //2x and 4x oversampling for the distortion, both ready so switching never allocates
+    for (int i = 0; i < 2; ++i)
+    {
+        oversamplers[i] = std::make_unique<juce::dsp::Oversampling<float>>((size_t) numChannels, (size_t) (i + 1),
+            juce::dsp::Oversampling<float>::filterHalfBandFIREquiripple, true);
+        oversamplers[i]->initProcessing((size_t) samplesPerBlock);
+    }
+
+    dryDelay.prepare({ sampleRate, (juce::uint32) samplesPerBlock, (juce::uint32) numChannels });
+    dryDelay.reset();
+
+    //every temporary buffer the stages use in a block comes out of here, the stages only ever see one control block
+    preparedBlockSize = juce::jmax(1, samplesPerBlock);
+    scratch.prepare(numChannels, juce::jmin(controlBlockSize, preparedBlockSize), scratchViewsPerBlock);
+
+    //the oversamplers don't say what they hold, it's mostly a buffer per stage of every channel at that stage's
+    //rate, their filter state is small next to that
+    size_t oversampledSamples = 0;
+
+    for (int i = 0; i < 2; ++i)
+        for (int stage = 1; stage <= i + 1; ++stage)
+            oversampledSamples += (size_t) numChannels * (size_t) (samplesPerBlock << stage);
+
+    preparedBytes = scratch.getSizeInBytes() + oversampledSamples * sizeof(float)
+                  + getDelaySizeInBytes(dryDelay, numChannels)
+                  + getDelaySizeInBytes(reverbDryDelay, 2) + getDelaySizeInBytes(chorusDryDelay, 2)
+                  + reverbReducer.getSizeInBytes() + chorusReducer.getSizeInBytes();
+
+    crushStates.clear();
+
+    for (int channel = 0; channel < juce::jmax(1, numChannels); ++channel)
+        crushStates.emplace_back(channel);
+    antiAliasStates.assign((size_t) juce::jmax(1, numChannels) * 2, Distortion::AntiAliasState());
+    fadeAntiAliasStates.assign(antiAliasStates.size(), Distortion::AntiAliasState());
+
+    limiter.setEnabled(limiterEnabled->load() > 0.5f);
+    limiter.prepare(sampleRate, juce::jmin(controlBlockSize, samplesPerBlock), numChannels);
+
+    //nothing set the curve yet, the default one is compiled now instead of in the constructor
+    if (transferTables.getCurrentUnsafe() == nullptr)
+        loadTransferCurve();
+
+    updateLatency();
+    lastMorphAmount = morphParameter->load() / 100.0f;
+
+    //nothing has run yet, so the tier can start where it should be without a fade
+    activeQualityTier = getQualityTier();
+    activeOversampling = getOversamplingIndex(activeQualityTier);
+
+    sidechainFollower.prepare(sampleRate);
+
+    //nothing gets retired before the audio thread runs, an instance that only gets scanned never starts it
+    if (! isTimerRunning())
+        startTimer(500);
+
+    crushGateLevel.reset(sampleRate, 0.005);
+    crushGateLevel.setCurrentAndTargetValue(1.0f);
+    crushGateOpen = true;
+    modulationQuarterNotes = 0.0;
+
+    loudness.prepare(sampleRate, juce::jmin(controlBlockSize, samplesPerBlock));
+    autoGain.reset(sampleRate, 1.0);
+    autoGain.setCurrentAndTargetValue(1.0f);
+}
+
+void RealMagiVerbAudioProcessor::releaseResources()
+{
+    // When playback stops, you can use this as an opportunity to free up any
+    // spare memory, etc.
+    scratch.release();
+
+    const juce::ScopedLock lock(engineLock);
+    clearEngines();
+}
+
+#ifndef JucePlugin_PreferredChannelConfigurations
+bool RealMagiVerbAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) const
+{
+  #if JucePlugin_IsMidiEffect
+    juce::ignoreUnused (layouts);
+    return true;
+  #else
+    // This is the place where you check if the layout is supported.
+    // In this template code we only support mono or stereo.
+    // Some plugin hosts, such as certain GarageBand versions, will only
+    // load plugins that support stereo bus layouts.
+    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
+     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+        return false;
+
+    // This checks if the input layout matches the output layout
+   #if ! JucePlugin_IsSynth
+    if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
+        return false;
+
+    //the sidechain is optional, and can be mono or stereo when it's there
+    if (layouts.inputBuses.size() > 1)
+    {
+        auto sidechain = layouts.getChannelSet(true, 1);
+
+        if (! sidechain.isDisabled()
+         && sidechain != juce::AudioChannelSet::mono()
+         && sidechain != juce::AudioChannelSet::stereo())
+            return false;
+    }
+   #endif
+
+    return true;
+  #endif
+}
+#endif
+
+void RealMagiVerbAudioProcessor::processBlock (juce::AudioBuffer<float>& hostBuffer, juce::MidiBuffer& midiMessages)
+{
+    juce::ScopedNoDenormals noDenormals;
+
+    auto totalNumInputChannels  = getTotalNumInputChannels();
+    auto totalNumOutputChannels = getTotalNumOutputChannels();
+
+    for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
+        hostBuffer.clear (i, 0, hostBuffer.getNumSamples());
+
+    //the host buffer carries the sidechain channels too, everything below only touches the main bus
+    auto mainBuffer = getBusBuffer(hostBuffer, false, 0);
+    auto sidechainBuffer = getBusCount(true) > 1 ? getBusBuffer(hostBuffer, true, 1) : juce::AudioBuffer<float>();
+
+    //the block is cut up on a fixed control grid, parameters and coefficients are picked up again for every
+    //piece so automation sounds the same whatever buffer size the host uses, and no stage (or the scratch arena)
+    //ever sees more samples than it was prepared for
+    auto numSamples = mainBuffer.getNumSamples();
+    auto chunkSize  = juce::jmin(controlBlockSize, preparedBlockSize);
+
+    updateTransport(numSamples);
+
+    //running free the entropy moves once per host block like it always did, not once per control block, which would
+    //turn it into noise on the chorus
+    entropyDraw = random.nextFloat();
+
+    for (int start = 0; start < numSamples; start += chunkSize)
+    {
+        auto todo = juce::jmin(chunkSize, numSamples - start);
+
+        juce::AudioBuffer<float> chunk(mainBuffer.getArrayOfWritePointers(), mainBuffer.getNumChannels(), start, todo);
+        juce::AudioBuffer<float> sidechainChunk;
+
+        if (sidechainBuffer.getNumChannels() > 0)
+            sidechainChunk.setDataToReferTo(sidechainBuffer.getArrayOfWritePointers(), sidechainBuffer.getNumChannels(), start, todo);
+
+        processChunk(chunk, sidechainChunk, transport.getPosition(start));
+    }
+}
+
+void RealMagiVerbAudioProcessor::updateTransport(int numSamples)
+{
+    transport.synced = false;
+    transport.looping = false;
+
+    if (modulationSync->load() < 0.5f)
+        return;
+
+    juce::AudioPlayHead::CurrentPositionInfo info;
+    auto* playHead = getPlayHead();
+
+    //without a tempo there's nothing to lock to, everything runs free
+    if (playHead == nullptr || ! playHead->getCurrentPosition(info) || info.bpm <= 0.0)
+        return;
+
+    if (info.isPlaying)
+        modulationQuarterNotes = info.ppqPosition;
+
+    transport.synced = true;
+    transport.quarterNotes = modulationQuarterNotes;
+    transport.quarterNotesPerSample = info.bpm / (60.0 * getSampleRate());
+
+    //the chunks after the loop end would otherwise run on past it until the host's next block jumps back
+    transport.looping   = info.isPlaying && info.isLooping && info.ppqLoopEnd > info.ppqLoopStart;
+    transport.loopStart = info.ppqLoopStart;
+    transport.loopEnd   = info.ppqLoopEnd;
+
+    modulationQuarterNotes = transport.getPosition(numSamples);
+}
+
+double RealMagiVerbAudioProcessor::getSyncDivisionInQuarterNotes() const noexcept
+{
+    //in the order of the Sync Division choices
+    static const double divisions[] = { 8.0, 4.0, 2.0, 1.0, 0.5, 0.25, 0.125,
+                                        1.5, 0.75, 0.375,
+                                        2.0 / 3.0, 1.0 / 3.0, 1.0 / 6.0 };
+
+    return divisions[juce::jlimit(0, (int) juce::numElementsInArray(divisions) - 1, (int) syncDivision->load())];
+}
+
+void RealMagiVerbAudioProcessor::processChunk(juce::AudioBuffer<float>& buffer, juce::AudioBuffer<float>& sidechainBuffer,
+                                              double quarterNotes)
+{
+    //every scratch view from the last chunk is given back
+    scratch.reset();
+
+    loudness.pushInput(buffer);
+
+    //everything the stages need to know about this block
+    BlockState state;
+    auto& params = state.params;
+
+    //a change of tier, or of Oversampling under As Set, swaps over straight away, a new oversampling has the drive
+    //stage run both the old way and the new way for a while and crossfade, so going from 1x to 4x oversampling and
+    //back never jumps and the rest of the chain, the dry and the reverb tail included, just carries on
+    //the shaper tiers agree to within 1e-4, a change of just the shaper quality keeps the same filters and swaps
+    auto tier = getQualityTier();
+    auto fadeFromOversampling = -1;
+    auto fadeFromShaperQuality = getShaperQuality(activeQualityTier);
+
+    if (tier != activeQualityTier || getOversamplingIndex(tier) != activeOversampling)
+    {
+        if (getOversamplingIndex(tier) != activeOversampling)
+            fadeFromOversampling = activeOversampling;
+
+        activeQualityTier = tier;
+        activeOversampling = getOversamplingIndex(tier);
+    }
+
+    //every parameter is read once, from one consistent snapshot
+    readParameters(params);
+
+    //with both morph snapshots stored the Morph knob decides the sound instead of the individual knobs
+    state.morphAmount = morphParameter->load() / 100.0f;
+    auto* morphs = morphSnapshots.get();
+    bool morphing = morphs != nullptr && morphs->active;
+
+    if (morphing)
+        params = ParameterSnapshot::morph(morphs->a, morphs->b, state.morphAmount);
+
+    //the sidechain envelope ducks the reverb's wet level and pushes the distortion gain
+    sidechainFollower.setAttackRelease(sidechainAttack->load(), sidechainRelease->load());
+
+    auto envelope = juce::jmin(1.0f, sidechainFollower.process(sidechainBuffer, 0, buffer.getNumSamples()));
+    auto duckAmount = envelope * sidechainDuck->load() / 100;
+
+    params[SoundParam::distGain] *= 1.0f + envelope * sidechainDrive->load() / 100;
+
+    /*I really wanted to make the random component more natrual, but this is the right now solution, nothing is in stone
+    first you get the vlaue of the slider, make that value the limit of a range
+    then generate a random number in that range, use that random number as you will
+    knowing that, that number will never surpass the limit of randomInput*/
+    int randomInput = (int) params[SoundParam::entropy];
+
+    //we can't manipulate the range in nextInt() but we can in a range
+    juce::Range<int> randRange = {0, randomInput};
+
+    //synced, the division cuts the song into steps, the chorus goes round once a step and every step gets its own
+    //random number worked out from which step it is, so a loop or a bounce always gets the same ones
+    auto division = getSyncDivisionInQuarterNotes();
+    auto step = std::floor(quarterNotes / division);
+
+    //generate a random number between 0 and the knob value
+    int randNum;
+
+    if (transport.synced)
+    {
+        juce::Random stepRandom((juce::int64) step * 2654435761LL + 1);
+        randNum = stepRandom.nextInt(randRange);
+    }
+    else
+    {
+        randNum = juce::jlimit(0, juce::jmax(0, randomInput - 1), (int) (entropyDraw * (float) randomInput));
+    }
+
+    state.drive = params[SoundParam::distGain] + (randNum / 100);
+
+    //the Distortion Type of each morph snapshot, they get crossfaded instead of stepped
+    auto choice = (int) params[SoundParam::distChoice];
+    state.morphChoices[0] = morphing ? (int) morphs->a[SoundParam::distChoice] : choice;
+    state.morphChoices[1] = morphing ? (int) morphs->b[SoundParam::distChoice] : choice;
+
+    //a shape can't be interpolated, so while morphing between two different ones both run and get crossfaded
+    state.crossfadeShapes = morphing && state.morphChoices[0] != state.morphChoices[1];
+
+    //parallel blends and oversampling of the drive stage
+    state.distortionMix = distortionMix->load() / 100;
+    state.crushMix      = crushMix->load() / 100;
+    state.dither        = (Dither) juce::jlimit(0, 2, (int) ditherMode->load());
+
+    //Crush Gate, synced the crusher is only in for the first half of every step, its Rate Divide hold starts again
+    //when it comes back so the held samples fall on the step
+    auto gateOpen = ! (transport.synced && crushGate->load() > 0.5f) || quarterNotes / division - step < 0.5;
+
+    if (gateOpen && ! crushGateOpen)
+        for (auto& crushState : crushStates)
+            crushState.counter = 0;
+
+    crushGateOpen = gateOpen;
+    crushGateLevel.setTargetValue(gateOpen ? 1.0f : 0.0f);
+    state.crushMix *= crushGateLevel.skip(buffer.getNumSamples());
+    state.oversampling  = activeOversampling;
+    state.shaperQuality = getShaperQuality(activeQualityTier);
+    state.antiAliasing  = (Distortion::AntiAliasing) juce::jlimit(0, 2, (int) antiAliasing->load());
+    state.customCurve   = transferTables.get();
+    state.chainedShapes = chainedShapes.load(std::memory_order_relaxed);
+
+    if (fadeFromOversampling >= 0)
+        startDriveFade(fadeFromOversampling, fadeFromShaperQuality, state);
+
+    if (driveFadeFrom >= 0)
+    {
+        state.fadeFromOversampling  = driveFadeFrom;
+        state.fadeFromShaperQuality = driveFadeFromQuality;
+        state.fadeHold              = driveFadeHold;
+        state.fadePosition          = driveFadePosition;
+
+        driveFadePosition += buffer.getNumSamples();
+
+        //this chunk still runs both, the old way stops after it
+        if (driveFadePosition >= driveFadeHold + controlBlockSize)
+            driveFadeFrom = -1;
+    }
+
+    //a stage that's been all the way down for a while gives its engines back, a bounce keeps them
+    if (! isNonRealtime())
+    {
+        auto releaseAfter = (juce::int64) (engineReleaseSeconds * getSampleRate());
+
+        reverbIdleSamples = params[SoundParam::revDryWet] > 0.0f ? 0 : reverbIdleSamples + buffer.getNumSamples();
+        chorusIdleSamples = params[SoundParam::modAmount] > 0.0f ? 0 : chorusIdleSamples + buffer.getNumSamples();
+
+        if (reverbIdleSamples > releaseAfter && reverbEngines.release())
+            reverbsReleased = true;
+
+        if (chorusIdleSamples > releaseAfter && chorusEngines.release())
+            chorusesReleased = true;
+    }
+
+    //the reverb and the chorus only get their memory once they're turned up, until it arrives they pass the dry through
+    state.reverbs  = reverbEngines.get();
+    state.choruses = chorusEngines.get();
+
+    //the reverb stage asks for its own, only once the algorithmic reverb is what would play
+    if (state.choruses == nullptr && params[SoundParam::modAmount] > 0.0f)
+        requestEngines(chorusRequested);
+
+    //which part of the stereo image each stage works on
+    state.chorusRouting = (StereoRouting) (int) chorusRouting->load();
+    state.driveRouting  = (StereoRouting) (int) driveRouting->load();
+    state.reverbRouting = (StereoRouting) (int) reverbRouting->load();
+
+    state.convolution = reverbMode->load() > 0.5f;
+    state.parallel    = parallelDsp->load() > 0.5f;
+
+    state.reducedReverb = state.reverbs != nullptr && isReverbReduced();
+    state.reducedChorus = state.choruses != nullptr && isChorusReduced();
+
+    //all the values we got from the slider, and pass them to the reverb::parameters object
+    reverbParameters.roomSize     = params[SoundParam::revSize] / 100;
+    reverbParameters.damping      = params[SoundParam::revDamp] / 100;
+    reverbParameters.width        = params[SoundParam::revWidth] / 100;
+    reverbParameters.wetLevel     = params[SoundParam::revDryWet] / 100 * (1.0f - duckAmount);
+    reverbParameters.dryLevel     = 1.f - params[SoundParam::revDryWet] / 100;
+
+    //pass those parameters to the reverb object
+    if (state.reverbs != nullptr)
+    {
+        state.reverbs->left.setParameters(reverbParameters);
+        state.reverbs->right.setParameters(reverbParameters);
+    }
+
+    //the low rate reverb is all wet, its dry comes back in at the full rate
+    if (state.reducedReverb)
+    {
+        auto wetOnly = reverbParameters;
+        wetOnly.dryLevel = 0.0f;
+        state.reverbs->reducedLeft->setParameters(wetOnly);
+        state.reverbs->reducedRight->setParameters(wetOnly);
+    }
+
+    //the convolution reverb has no room to size, so Size is how much of the impulse plays and Width is the predelay
+    if (state.convolution)
+        convolutionReverb.setParameters(params[SoundParam::revWidth] / 100 * ConvolutionReverb::maxPredelayMs,
+                                        juce::jmap(params[SoundParam::revSize] / 100, 0.2f, 1.0f),
+                                        params[SoundParam::revDamp] / 100,
+                                        state.parallel);
+
+    //the chorus only stores these, the lfos and delays get worked out when it runs
+    if (state.choruses != nullptr)
+    {
+        EnsembleChorus::Parameters chorusParameters;
+        chorusParameters.numVoices      = (int) chorusVoices->load();
+        chorusParameters.rate           = (params[SoundParam::modRate] + randNum) / 100;
+        chorusParameters.depth          = (params[SoundParam::modAmount] + randNum) / 100 * 0.25f;
+        chorusParameters.centreDelay    = chorusDelay->load();
+        chorusParameters.feedback       = chorusFeedback->load() / 100;
+        chorusParameters.mix            = params[SoundParam::modAmount] / 100;
+        chorusParameters.interpolation  = (EnsembleChorus::Interpolation) juce::jlimit(0, 2, (int) chorusInterpolation->load());
+
+        //synced, once round per step at the host's tempo, the entropy still moves the depth but not the rate
+        if (transport.synced)
+        {
+            chorusParameters.rate       = (float) (transport.quarterNotesPerSample * getSampleRate() / division);
+            chorusParameters.synced     = true;
+            chorusParameters.position   = quarterNotes / division;
+        }
+
+        if (activeQualityTier == QualityTier::draft)
+            chorusParameters.interpolation = EnsembleChorus::Interpolation::linear;
+        else if (activeQualityTier == QualityTier::best)
+            chorusParameters.interpolation = EnsembleChorus::Interpolation::lagrange;
+
+        state.choruses->chorus.setParameters(chorusParameters);
+
+        //same goes for the chorus, the mix happens at the full rate
+        chorusParameters.mix = 1.0f;
+        state.choruses->reducedChorus.setParameters(chorusParameters);
+    }
+
+    //one indirect call for the whole chain, the stages inside it are called directly
+    auto chain = chainOrders[activeChainOrder.load(std::memory_order_acquire)];
+    (this->*chain)(buffer, state);
+
+    //stages can leave the buffer in M/S, the host always gets L/R back
+    setMidSideDomain(buffer, false);
+
+    buffer.applyGain(params[SoundParam::postGain]);
+
+    //measured before the compensation, which would otherwise chase itself, it moves over a second so it never pumps
+    loudness.pushOutput(buffer);
+    autoGain.setTargetValue(autoGainEnabled->load() > 0.5f ? loudness.getMatchingGain() : 1.0f);
+    autoGain.applyGain(buffer, buffer.getNumSamples());
+
+    //it runs while it's off as well, so switching it is a short crossfade instead of a jump
+    limiter.setEnabled(limiterEnabled->load() > 0.5f);
+    limiter.setCeiling(limiterCeiling->load());
+    limiter.process(buffer);
+
+    lastMorphAmount = state.morphAmount;
+}
+
+template <Stage stage>
+void RealMagiVerbAudioProcessor::processStage(juce::AudioBuffer<float>& buffer, const BlockState& state)
+{
+    //the filters are the same on both channels, so they don't care which domain the buffer is in
+    if (stage == Stage::filter)
+    {
+        processFilterStage(buffer, state);
+        return;
+    }
+
+    //stage is known at compile time, so every chain instantiation keeps just the one branch
+    auto process = [this, &state](juce::AudioBuffer<float>& target)
+    {
+        if (stage == Stage::chorus)
+            processChorusStage(target, state);
+        else if (stage == Stage::drive)
+            processDriveStage(target, state);
+        else if (stage == Stage::reverb)
+            processReverbStage(target, state);
+    };
+
+    auto routing = stage == Stage::chorus ? state.chorusRouting
+                 : stage == Stage::drive  ? state.driveRouting
+                                          : state.reverbRouting;
+
+    if (buffer.getNumChannels() < 2)
+    {
+        process(buffer);
+        return;
+    }
+
+    //only converts when the domain changes, neighbouring M/S stages share one encode
+    setMidSideDomain(buffer, routing != StereoRouting::stereo);
+
+    if (routing == StereoRouting::midOnly || routing == StereoRouting::sideOnly)
+    {
+        //refers to the one channel, no copy
+        juce::AudioBuffer<float> single(buffer.getArrayOfWritePointers() + (routing == StereoRouting::midOnly ? 0 : 1),
+                                        1, buffer.getNumSamples());
+        process(single);
+    }
+    else
+    {
+        process(buffer);
+    }
+}
+
+void RealMagiVerbAudioProcessor::setMidSideDomain(juce::AudioBuffer<float>& buffer, bool shouldBeMidSide)
+{
+    if (midSideDomain == shouldBeMidSide || buffer.getNumChannels() < 2)
+        return;
+
+    MidSide::convert(buffer.getWritePointer(0), buffer.getWritePointer(1), buffer.getNumSamples());
+    midSideDomain = shouldBeMidSide;
+}
+
+template <Stage... stages>
+void RealMagiVerbAudioProcessor::processChain(juce::AudioBuffer<float>& buffer, const BlockState& state)
+{
+    //expands into one direct call per stage, in order
+    (void) std::initializer_list<int>{ (processStage<stages>(buffer, state), 0)... };
+}
+
+//the orders the Chain Order parameter can pick from, same order as its choice list
+const RealMagiVerbAudioProcessor::ChainFunction RealMagiVerbAudioProcessor::chainOrders[numChainOrders] =
+{
+    &RealMagiVerbAudioProcessor::processChain<Stage::chorus, Stage::drive, Stage::reverb, Stage::filter>,
+    &RealMagiVerbAudioProcessor::processChain<Stage::chorus, Stage::filter, Stage::drive, Stage::reverb>,
+    &RealMagiVerbAudioProcessor::processChain<Stage::reverb, Stage::chorus, Stage::drive, Stage::filter>,
+    &RealMagiVerbAudioProcessor::processChain<Stage::drive, Stage::chorus, Stage::reverb, Stage::filter>,
+    &RealMagiVerbAudioProcessor::processChain<Stage::filter, Stage::drive, Stage::chorus, Stage::reverb>,
+    &RealMagiVerbAudioProcessor::processChain<Stage::drive, Stage::reverb, Stage::chorus, Stage::filter>
+};
+
+void RealMagiVerbAudioProcessor::parameterChanged(const juce::String& parameterID, float newValue)
+{
+    //the chain is swapped with a single atomic store, the audio thread picks it up on its next block
+    if (parameterID == "Chain Order")
+        activeChainOrder.store(juce::jlimit(0, numChainOrders - 1, (int) newValue), std::memory_order_release);
+
+    //the oversampling filters, the anti-aliased shapes, the rate reducers and the limiter's lookahead delay the signal,
+    //the host needs to know by how much
+    if (parameterID == "Oversampling" || parameterID == "Anti-Aliasing" || parameterID == "Reduced Rate" || parameterID == "Reverb Mode"
+        || parameterID == "Quality Mode" || parameterID == "Output Limiter")
+    {
+        latencyChanged = true;
+        triggerAsyncUpdate();
+    }
+}
+
+void RealMagiVerbAudioProcessor::setNonRealtime(bool isNonRealtime) noexcept
+{
+    AudioProcessor::setNonRealtime(isNonRealtime);
+
+    //on Auto a bounce gets the expensive tier, which oversamples more and so adds latency
+    updateLatency();
+
+    //an effect automated up from 0 during a bounce can't wait for the message thread to build its engines
+    if (isNonRealtime)
+    {
+        const juce::ScopedLock lock(engineLock);
+
+        collectEngines();
+        buildEngines(true, true);
+    }
+}
+
+void RealMagiVerbAudioProcessor::requestEngines(std::atomic<bool>& requested) noexcept
+{
+    if (! requested.exchange(true))
+        triggerAsyncUpdate();
+}
+
+void RealMagiVerbAudioProcessor::handleAsyncUpdate()
+{
+    if (latencyChanged.exchange(false))
+        updateLatency();
+
+    const juce::ScopedLock lock(engineLock);
+
+    collectEngines();
+    buildEngines(reverbRequested.load(), chorusRequested.load());
+}
+
+void RealMagiVerbAudioProcessor::collectEngines()
+{
+    //read before collecting, engines the audio thread let go of are always in the retired slot by then
+    auto reverbsGone    = reverbsReleased.exchange(false);
+    auto chorusesGone   = chorusesReleased.exchange(false);
+
+    reverbEngines.collectGarbage();
+    chorusEngines.collectGarbage();
+
+    //the next time the stage gets turned up it asks for new ones
+    if (reverbsGone)
+    {
+        reverbBytes = 0;
+        reverbRequested = false;
+    }
+
+    if (chorusesGone)
+    {
+        chorusBytes = 0;
+        chorusRequested = false;
+    }
+}
+
+void RealMagiVerbAudioProcessor::clearEngines()
+{
+    reverbEngines.clearUnsafe();
+    chorusEngines.clearUnsafe();
+    reverbBytes = 0;
+    chorusBytes = 0;
+    reverbRequested = false;
+    chorusRequested = false;
+    reverbsReleased = false;
+    chorusesReleased = false;
+}
+
+void RealMagiVerbAudioProcessor::buildEngines(bool buildReverb, bool buildChorus)
+{
+    //a request can come in again while the last one is still pending, the bytes say whether it was already built
+    if (buildReverb && reverbBytes.load() == 0)
+    {
+        auto reverbs = std::make_unique<ReverbEngines>(engineSampleRate, engineBlockSize, reducedFactor);
+        reverbBytes = reverbs->getSizeInBytes();
+        reverbEngines.set(std::move(reverbs));
+    }
+
+    if (buildChorus && chorusBytes.load() == 0)
+    {
+        auto choruses = std::make_unique<ChorusEngines>(engineSampleRate, engineBlockSize, reducedFactor);
+        chorusBytes = choruses->getSizeInBytes();
+        chorusEngines.set(std::move(choruses));
+    }
+}
+
+size_t RealMagiVerbAudioProcessor::getMemoryUsage() const
+{
+    return reverbBytes.load() + chorusBytes.load() + preparedBytes.load() + convolutionReverb.getSizeInBytes();
+}
+
+QualityTier RealMagiVerbAudioProcessor::getQualityTier() const noexcept
+{
+    switch ((int) qualityMode->load())
+    {
+        case 1:     return isNonRealtime() ? QualityTier::best : QualityTier::draft;
+        case 2:     return QualityTier::best;
+        default:    return QualityTier::asSet;
+    }
+}
+
+int RealMagiVerbAudioProcessor::getOversamplingIndex(QualityTier tier) const noexcept
+{
+    switch (tier)
+    {
+        case QualityTier::draft:    return 0;
+        case QualityTier::best:     return 2;
+        case QualityTier::asSet:
+        default:                    return juce::jlimit(0, 2, (int) oversamplingChoice->load());
+    }
+}
+
+ShapingFunctions::Quality RealMagiVerbAudioProcessor::getShaperQuality(QualityTier tier) const noexcept
+{
+    switch (tier)
+    {
+        case QualityTier::draft:    return ShapingFunctions::Quality::lookupTable;
+        case QualityTier::best:     return ShapingFunctions::Quality::exact;
+        case QualityTier::asSet:
+        default:                    return (ShapingFunctions::Quality) juce::jlimit(0, 2, (int) shaperQuality->load());
+    }
+}
+
+//copies the block into dry, a whole delay line's worth late, for the stages that go through a rate reducer
+static void delayDry(IntegerDelay& delay, const juce::AudioBuffer<float>& buffer, juce::AudioBuffer<float>& dry)
+{
+    for (auto channel = 0; channel < buffer.getNumChannels(); ++channel)
+    {
+        auto* in = buffer.getReadPointer(channel);
+        auto* out = dry.getWritePointer(channel);
+
+        for (auto sample = 0; sample < buffer.getNumSamples(); ++sample)
+        {
+            delay.pushSample(channel, in[sample]);
+            out[sample] = delay.popSample(channel);
+        }
+    }
+}
+
+void RealMagiVerbAudioProcessor::processChorusStage(juce::AudioBuffer<float>& buffer, const BlockState& state)
+{
+    //never turned up, so there's nothing to mix in
+    if (state.choruses == nullptr)
+        return;
+
+    if (! state.reducedChorus)
+    {
+        //mid only and side only stages get a single channel, the chorus only runs its sine side then
+        state.choruses->chorus.process(buffer);
+        chorusWasReduced = false;
+        return;
+    }
+
+    auto dry = scratch.getBuffer(buffer.getNumChannels(), buffer.getNumSamples());
+
+    if (dry.getNumChannels() == 0)
+        return;
+
+    //whatever is left in there is from the last time it was on
+    if (! chorusWasReduced)
+    {
+        chorusReducer.reset();
+        chorusDryDelay.reset();
+        state.choruses->reducedChorus.reset();
+        chorusWasReduced = true;
+    }
+
+    delayDry(chorusDryDelay, buffer, dry);
+
+    auto low = chorusReducer.processDown(buffer);
+
+    if (low.getNumSamples() > 0)
+        state.choruses->reducedChorus.process(low);
+
+    chorusReducer.processUp(buffer);
+
+    //the reduced chorus is all wet
+    auto mix = juce::jlimit(0.0f, 1.0f, state.params[SoundParam::modAmount] / 100);
+
+    for (auto channel = 0; channel < buffer.getNumChannels(); ++channel)
+    {
+        auto* wet = buffer.getWritePointer(channel);
+        juce::FloatVectorOperations::multiply(wet, mix, buffer.getNumSamples());
+        juce::FloatVectorOperations::addWithMultiply(wet, dry.getReadPointer(channel), 1.0f - mix, buffer.getNumSamples());
+    }
+}
+
+CrushState::CrushState(int channel)
+{
+    //an odd multiplier never takes a nonzero seed to 0, which is the one state xorshift can't leave
+    for (int lane = 0; lane < DspKernels::noiseLanes; ++lane)
+        noise[lane] = 0x9e3779b9u * (unsigned int) (channel * DspKernels::noiseLanes + lane + 1);
+}
+
+//bit crush and rate divide, in place
+//the held sample and where we are in the hold carry over, the hold is longer than a control block at high Rate Divide
+static void bitCrush(float* writePointer, int numSamples, float bitDepth, float rateDivide, Dither dither,
+                     CrushState& crushState)
+{
+    float totalQLevels = powf(2, bitDepth);
+
+    int rD = rateDivide > 1 ? juce::jmax(1, (int) rateDivide / 2) : 1;
+
+    auto& kernels = DspKernels::get();
+
+    //past 24 bits a step is finer than a float can tell apart at full scale, noise would add nothing there
+    if (dither == Dither::none || bitDepth >= 24.0f)
+    {
+        //the whole block goes onto the grid first, the same as val - fmodf(val, 1 / totalQLevels) but vectorised
+        kernels.quantise(writePointer, numSamples, totalQLevels);
+    }
+    else
+    {
+        //the noise for a control block at a time, each channel's lanes carry on where its last block left them
+        const int noiseBlockSize = 32;
+        float noise[noiseBlockSize];
+
+        for (int start = 0; start < numSamples; start += noiseBlockSize)
+        {
+            auto todo = juce::jmin(noiseBlockSize, numSamples - start);
+            kernels.ditherNoise(noise, todo, crushState.noise);
+
+            if (dither == Dither::tpdf)
+                kernels.ditheredQuantise(writePointer + start, todo, totalQLevels, noise);
+            else
+                kernels.shapedQuantise(writePointer + start, todo, totalQLevels, noise, &crushState.error);
+        }
+    }
+
+    //without a rate divide every sample is its own held one, which it already is
+    if (rD == 1 && crushState.counter == 0)
+        return;
+
+    for (auto sample = 0; sample < numSamples; ++sample)
+    {
+        if (crushState.counter == 0)
+            crushState.held = writePointer[sample];
+
+        writePointer[sample] = crushState.held;
+
+        if (++crushState.counter >= rD)
+            crushState.counter = 0;
+    }
+}
+
+void RealMagiVerbAudioProcessor::processDriveStage(juce::AudioBuffer<float>& buffer, const BlockState& state)
+{
+    //all the values used in the distortion algorithms
+    auto& params        = state.params;
+    auto numSamples     = buffer.getNumSamples();
+    auto numChannels    = buffer.getNumChannels();
+
+    //while an oversampling change fades, the shapes run the old way on a copy as well and this chunk crossfades from
+    //that to the new way, only the shapes are affected so the crusher still runs once
+    auto previousState = state;
+    previousState.oversampling  = state.fadeFromOversampling;
+    previousState.shaperQuality = state.fadeFromShaperQuality;
+
+    juce::AudioBuffer<float> previous, previousDry;
+
+    if (state.fadeFromOversampling >= 0)
+        previous = scratch.getBuffer(numChannels, numSamples);
+
+    bool fading = previous.getNumChannels() > 0;
+
+    auto shapeDelay     = getDriveDelay(state);
+    auto previousDelay  = fading ? getDriveDelay(previousState) : 0.0f;
+
+    //parallel distortion, the dry side is what came into the stage
+    juce::AudioBuffer<float> dryBuffer;
+
+    if (state.distortionMix < 1.0f || shapeDelay > 0.0f || previousDelay > 0.0f)
+        dryBuffer = scratch.getBuffer(numChannels, numSamples);
+
+    if (fading && dryBuffer.getNumChannels() > 0)
+        previousDry = scratch.getBuffer(numChannels, numSamples);
+
+    //with oversampling or anti-aliasing on the dry side runs through a delay so it lines up with the wet, it runs
+    //even while the mix is at 100 so turning the mix down never plays stale samples
+    if (previousDry.getNumChannels() > 0)
+    {
+        auto delaying = previousDelay > 0.0f || shapeDelay > 0.0f;
+
+        //the delay wasn't running the old way, what it still holds is from whenever it last was
+        if (delaying && ! dryDelayRunning)
+            dryDelay.reset();
+
+        dryDelayRunning = delaying;
+
+        //read at both delays, the second read moves the line on
+        for (auto channel = 0; channel < numChannels; ++channel)
+        {
+            auto* in        = buffer.getReadPointer(channel);
+            auto* dry       = dryBuffer.getWritePointer(channel);
+            auto* before    = previousDry.getWritePointer(channel);
+
+            for (auto sample = 0; sample < numSamples; ++sample)
+            {
+                if (delaying)
+                    dryDelay.pushSample(channel, in[sample]);
+
+                before[sample]  = previousDelay > 0.0f ? dryDelay.popSample(channel, previousDelay, shapeDelay <= 0.0f)
+                                                       : in[sample];
+                dry[sample]     = shapeDelay > 0.0f ? dryDelay.popSample(channel, shapeDelay) : in[sample];
+            }
+        }
+    }
+    else if (shapeDelay > 0.0f && dryBuffer.getNumChannels() > 0)
+    {
+        if (! dryDelayRunning)
+            dryDelay.reset();
+
+        dryDelayRunning = true;
+        dryDelay.setDelay(shapeDelay);
+
+        for (auto channel = 0; channel < numChannels; ++channel)
+        {
+            auto* in    = buffer.getReadPointer(channel);
+            auto* dry   = dryBuffer.getWritePointer(channel);
+
+            for (auto sample = 0; sample < numSamples; ++sample)
+            {
+                dryDelay.pushSample(channel, in[sample]);
+                dry[sample] = dryDelay.popSample(channel);
+            }
+        }
+    }
+    else
+    {
+        dryDelayRunning = false;
+
+        if (dryBuffer.getNumChannels() > 0)
+            for (auto channel = 0; channel < numChannels; ++channel)
+                dryBuffer.copyFrom(channel, 0, buffer, channel, 0, numSamples);
+    }
+
+    //the old way carries on with its own oversampler and anti-aliasing states, nothing it was using gets cleared
+    if (fading)
+    {
+        for (auto channel = 0; channel < numChannels; ++channel)
+            previous.copyFrom(channel, 0, buffer, channel, 0, numSamples);
+
+        processDriveShapes(previous, previousDry, previousState, fadeAntiAliasStates);
+    }
+
+    processDriveShapes(buffer, dryBuffer, state, antiAliasStates);
+
+    //the new way stays out until its filters have filled up, then comes in over a control block
+    if (fading)
+    {
+        for (auto channel = 0; channel < numChannels; ++channel)
+        {
+            auto* out = buffer.getWritePointer(channel);
+            auto* old = previous.getReadPointer(channel);
+
+            for (auto sample = 0; sample < numSamples; ++sample)
+            {
+                auto gain = juce::jlimit(0.0f, 1.0f, (float) (state.fadePosition + sample + 1 - state.fadeHold)
+                                                     / (float) controlBlockSize);
+                out[sample] = old[sample] + gain * (out[sample] - old[sample]);
+            }
+        }
+    }
+
+    //the crusher has its own blend, it runs on a copy because rate divide reads back what it already crushed
+    juce::AudioBuffer<float> crushBuffer;
+
+    if (state.crushMix < 1.0f)
+        crushBuffer = scratch.getBuffer(numChannels, numSamples);
+
+    bool parallelCrush = crushBuffer.getNumChannels() > 0;
+
+    for (auto channel = 0; channel < numChannels; ++channel)
+    {
+        auto* writePointer = buffer.getWritePointer(channel);
+        auto& crushState = crushStates[(size_t) juce::jmin(channel, (int) crushStates.size() - 1)];
+
+        if (parallelCrush)
+        {
+            auto* crushed = crushBuffer.getWritePointer(channel);
+            juce::FloatVectorOperations::copy(crushed, writePointer, numSamples);
+
+            bitCrush(crushed, numSamples, params[SoundParam::bitDepth], params[SoundParam::rateDiv], state.dither, crushState);
+
+            juce::FloatVectorOperations::multiply(writePointer, 1.0f - state.crushMix, numSamples);
+            juce::FloatVectorOperations::addWithMultiply(writePointer, crushed, state.crushMix, numSamples);
+        }
+        else
+        {
+            //bit crush is always applied
+            bitCrush(writePointer, numSamples, params[SoundParam::bitDepth], params[SoundParam::rateDiv], state.dither,
+                     crushState);
+        }
+    }
+}
+
+void RealMagiVerbAudioProcessor::processDriveShapes(juce::AudioBuffer<float>& buffer, const juce::AudioBuffer<float>& dryBuffer,
+                                                     const BlockState& state, std::vector<Distortion::AntiAliasState>& shapeStates)
+{
+    auto numSamples     = buffer.getNumSamples();
+    auto numChannels    = buffer.getNumChannels();
+
+    auto* oversampler = state.oversampling > 0 ? oversamplers[state.oversampling - 1].get() : nullptr;
+
+    buffer.applyGain(state.params[SoundParam::preGain]);
+
+    juce::dsp::AudioBlock<float> block(buffer);
+
+    if (oversampler != nullptr)
+    {
+        auto upBlock = oversampler->processSamplesUp(block);
+        processDistortionShapes(upBlock, state, shapeStates);
+        oversampler->processSamplesDown(block);
+    }
+    else
+    {
+        processDistortionShapes(block, state, shapeStates);
+    }
+
+    if (state.distortionMix < 1.0f && dryBuffer.getNumChannels() > 0)
+    {
+        for (auto channel = 0; channel < numChannels; ++channel)
+        {
+            auto* wet = buffer.getWritePointer(channel);
+            juce::FloatVectorOperations::multiply(wet, state.distortionMix, numSamples);
+            juce::FloatVectorOperations::addWithMultiply(wet, dryBuffer.getReadPointer(channel), 1.0f - state.distortionMix, numSamples);
+        }
+    }
+}
+
+float RealMagiVerbAudioProcessor::getDriveDelay(const BlockState& state) const noexcept
+{
+    //the anti-aliased shapes run late at whatever rate the shapes run at
+    auto delay = Distortion::getAntiAliasingDelay(state.antiAliasing);
+    auto* oversampler = state.oversampling > 0 ? oversamplers[state.oversampling - 1].get() : nullptr;
+
+    if (oversampler != nullptr)
+        delay = delay / (float) oversampler->getOversamplingFactor() + oversampler->getLatencyInSamples();
+
+    return delay;
+}
+
+void RealMagiVerbAudioProcessor::processDistortionShapes(juce::dsp::AudioBlock<float>& block, const BlockState& state,
+                                                         std::vector<Distortion::AntiAliasState>& shapeStates)
+{
+    auto numSamples = (int) block.getNumSamples();
+
+    Distortion::Settings settings;
+    settings.gain           = state.params[SoundParam::distGain];
+    settings.drive          = state.drive;
+    settings.quality        = state.shaperQuality;
+    settings.antiAliasing   = state.antiAliasing;
+    settings.customCurve    = state.customCurve;
+    settings.chainedShapes  = state.chainedShapes;
+
+    //two states per channel, one for each morph shape
+    auto numStates = (int) shapeStates.size() / 2;
+
+    //holds the second shape, at the oversampled rate if that's what the block is at
+    juce::AudioBuffer<float> morphBuffer;
+
+    if (state.crossfadeShapes)
+        morphBuffer = scratch.getBuffer((int) block.getNumChannels(), numSamples);
+
+    bool crossfade = morphBuffer.getNumChannels() > 0;
+
+    for (size_t channel = 0; channel < block.getNumChannels(); ++channel)
+    {
+        auto* writePointer = block.getChannelPointer(channel);
+        auto& firstState  = shapeStates[(size_t) juce::jmin((int) channel, numStates - 1)];
+        auto& secondState = shapeStates[(size_t) (numStates + juce::jmin((int) channel, numStates - 1))];
+
+        if (crossfade)
+        {
+            auto* otherPointer = morphBuffer.getWritePointer((int) channel);
+            juce::FloatVectorOperations::copy(otherPointer, writePointer, numSamples);
+
+            Distortion::process(state.morphChoices[0], writePointer, numSamples, settings, firstState);
+            Distortion::process(state.morphChoices[1], otherPointer, numSamples, settings, secondState);
+
+            //ramped from where the last block ended so automating the morph doesn't zipper
+            auto step = (state.morphAmount - lastMorphAmount) / (float) numSamples;
+
+            for (auto sample = 0; sample < numSamples; ++sample)
+            {
+                auto amount = lastMorphAmount + step * (float) (sample + 1);
+                writePointer[sample] += amount * (otherPointer[sample] - writePointer[sample]);
+            }
+        }
+        else
+        {
+            Distortion::process((int) state.params[SoundParam::distChoice], writePointer, numSamples, settings, firstState);
+
+            //the second shape picks up from the same input once a crossfade starts
+            secondState = firstState;
+        }
+    }
 }
 
-const juce::String RealMagiVerbAudioProcessor::getProgramName (int index)
+bool RealMagiVerbAudioProcessor::isReverbReduced() const
 {
-    return {};
+    //the convolution reverb stays at the full rate, its impulse response is at that rate
+    return reducedFactor > 1 && reducedRate->load() > 0.5f && reverbMode->load() < 0.5f;
 }
 
-void RealMagiVerbAudioProcessor::changeProgramName (int index, const juce::String& newName)
+bool RealMagiVerbAudioProcessor::isChorusReduced() const
 {
+    return reducedFactor > 1 && reducedRate->load() > 1.5f;
 }
 
-//==============================================================================
-void RealMagiVerbAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
+void RealMagiVerbAudioProcessor::updateLatency()
 {
-    // Use this method as the place to do any pre-playback
-    // initialisation that you need..
-    juce::dsp::ProcessSpec spec;
-    juce::dsp::ProcessSpec filterSpec;
+    auto index = getOversamplingIndex(getQualityTier());
+    float latency = 0.0f;
 
-    spec.sampleRate         = sampleRate;
-    spec.maximumBlockSize   = samplesPerBlock;
-    spec.numChannels        = 1;
+    //every reduced stage adds its filters
+    if (isReverbReduced())
+        latency += reverbReducer.getLatencyInSamples();
 
-    filterSpec.sampleRate       = sampleRate;
-    filterSpec.maximumBlockSize = samplesPerBlock;
-    filterSpec.numChannels      = 2;
+    if (isChorusReduced())
+        latency += chorusReducer.getLatencyInSamples();
 
-    leftReverb.prepare(spec);
-    rightReverb.prepare(spec);
-    leftChorus.prepare(spec);
-    rightChorus.prepare(spec);  
+    if (index > 0 && oversamplers[index - 1] != nullptr)
+        latency += oversamplers[index - 1]->getLatencyInSamples();
 
-    lowCutFilter.prepare(filterSpec);
-    highCutFilter.prepare(filterSpec);
-}
+    auto order = (Distortion::AntiAliasing) juce::jlimit(0, 2, (int) antiAliasing->load());
+    latency += Distortion::getAntiAliasingDelay(order) / (float) (1 << juce::jlimit(0, 2, index));
 
-void RealMagiVerbAudioProcessor::releaseResources()
-{
-    // When playback stops, you can use this as an opportunity to free up any
-    // spare memory, etc.
+    if (limiterEnabled->load() > 0.5f)
+        latency += limiter.getLatencyInSamples();
+
+    //the host only takes whole samples, the first order anti-aliasing's half (a quarter or an eighth of one when
+    //oversampled) isn't compensated, so against a dry copy on another track the output is that much late, the
+    //drive stage's own Distortion Mix is lined up with a fractional delay so it isn't affected
+    setLatencySamples((int) std::floor(latency));
 }
 
-#ifndef JucePlugin_PreferredChannelConfigurations
-bool RealMagiVerbAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) const
+void RealMagiVerbAudioProcessor::processReverbStage(juce::AudioBuffer<float>& buffer, const BlockState& state)
 {
-  #if JucePlugin_IsMidiEffect
-    juce::ignoreUnused (layouts);
-    return true;
-  #else
-    // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
-    // Some plugin hosts, such as certain GarageBand versions, will only
-    // load plugins that support stereo bus layouts.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
-        return false;
+    if (state.convolution)
+    {
+        auto dry = scratch.getBuffer(buffer.getNumChannels(), buffer.getNumSamples());
 
-    // This checks if the input layout matches the output layout
-   #if ! JucePlugin_IsSynth
-    if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
-        return false;
-   #endif
+        if (dry.getNumChannels() > 0)
+        {
+            for (auto channel = 0; channel < buffer.getNumChannels(); ++channel)
+                dry.copyFrom(channel, 0, buffer, channel, 0, buffer.getNumSamples());
 
-    return true;
-  #endif
-}
-#endif
+            //same dry and wet levels as the algorithmic reverb, so Dry/Wet and the ducking work the same
+            if (convolutionReverb.process(buffer))
+            {
+                for (auto channel = 0; channel < buffer.getNumChannels(); ++channel)
+                {
+                    auto* wet = buffer.getWritePointer(channel);
+                    juce::FloatVectorOperations::multiply(wet, reverbParameters.wetLevel, buffer.getNumSamples());
+                    juce::FloatVectorOperations::addWithMultiply(wet, dry.getReadPointer(channel), reverbParameters.dryLevel, buffer.getNumSamples());
+                }
 
-//enhanced modulation function
-float mod(float n, float d)
-{
-    n = fmod(n, d);
-    if (n < 0) n += d;
-    return n;
-}
+                return;
+            }
+        }
 
-//fast hyperbolic tanget function because std::tanh sucks
-//juce::dsp has a fast math namespace witha all the good shit
-float fast_tanh(float x) {
-    float x2 = x * x;
-    float a = x * (135135.0f + x2 * (17325.0f + x2 * (378.0f + x2)));
-    float b = 135135.0f + x2 * (62370.0f + x2 * (3150.0f + x2 * 28.0f));
-    return a / b;
-}
+        //no impulse response loaded yet, the algorithmic one stands in
+    }
 
-//fast approximation of arc tangent fucntion
-float fastAtan(float z)
-{
-    const float n1 = 0.97239411f;
-    const float n2 = -0.19194795f;
-    return (n1 + n2 * z * z) * z;
-}
+    //the dry level on its own until the reverbs the audio thread asked for arrive, they're only asked for here so
+    //the convolution reverb never builds them while it has an impulse to play
+    if (state.reverbs == nullptr)
+    {
+        //engines that were let go of can come back at the same address, they still have to fade in
+        arrivedReverbs = nullptr;
 
-void RealMagiVerbAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
-{
-    juce::ScopedNoDenormals noDenormals;
-    auto totalNumInputChannels  = getTotalNumInputChannels();
-    auto totalNumOutputChannels = getTotalNumOutputChannels();
+        if (state.params[SoundParam::revDryWet] > 0.0f)
+            requestEngines(reverbRequested);
 
-    for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
-        buffer.clear (i, 0, buffer.getNumSamples());
+        buffer.applyGain(reverbParameters.dryLevel);
+        return;
+    }
 
-    //sample block of the audio buffer
-    juce::dsp::AudioBlock<float> sampleBlock(buffer);
+    //new engines start on juce's default levels and take 10 ms to smooth over to ours, so for a bit longer than that
+    //they're crossfaded in from what the stage played while it waited
+    if (state.reverbs != arrivedReverbs)
+    {
+        arrivedReverbs = state.reverbs;
+        reverbArrival.setCurrentAndTargetValue(0.0f);
+        reverbArrival.setTargetValue(1.0f);
+    }
 
-    /*I really wanted to make the random component more natrual, but this is the right now solution, nothing is in stone
-    first you get the vlaue of the slider, make that value the limit of a range
-    then generate a random number in that range, use that random number as you will
-    knowing that, that number will never surpass the limit of randomInput*/
-    int randomInput = *apvts.getRawParameterValue("Entropy");
+    juce::AudioBuffer<float> waitingDry;
 
-    //we can't manipulate the range in nextInt() but we can in a range
-    juce::Range<int> randRange = {0, randomInput};
+    if (reverbArrival.isSmoothing())
+        waitingDry = scratch.getBuffer(buffer.getNumChannels(), buffer.getNumSamples());
 
-    //generate a random number between 0 and the knob value
-    int randNum = random.nextInt(randRange);
+    for (auto channel = 0; channel < waitingDry.getNumChannels(); ++channel)
+    {
+        waitingDry.copyFrom(channel, 0, buffer, channel, 0, buffer.getNumSamples());
+        waitingDry.applyGain(channel, 0, buffer.getNumSamples(), reverbParameters.dryLevel);
+    }
 
-    //all the values used in the distortion algorithms
-    auto pre        = apvts.getRawParameterValue("Pre-Gain");
-    auto post       = apvts.getRawParameterValue("Post-Gain");
-    auto bitDepth   = apvts.getRawParameterValue("Bit Depth");
-    auto rateDivide = apvts.getRawParameterValue("Rate Divide");
-    auto gain       = apvts.getRawParameterValue("Distortion Gain");
+    if (state.reducedReverb)
+    {
+        processReducedReverb(buffer, *state.reverbs);
+    }
+    else
+    {
+        reverbWasReduced = false;
 
-    distChoices choice = (distChoices)(int)apvts.getRawParameterValue("Distortion Type")->load();
+        juce::dsp::AudioBlock<float> sampleBlock(buffer);
 
-    //all the values we got from the slider, and pass them to the reverb::parameters object
-    reverbParameters.roomSize     = *apvts.getRawParameterValue("Reverb Size") / 100;
-    reverbParameters.damping      = *apvts.getRawParameterValue("Reverb Damping") / 100;
-    reverbParameters.width        = *apvts.getRawParameterValue("Reverb Width") / 100;
-    reverbParameters.wetLevel     = *apvts.getRawParameterValue("Reverb Dry/Wet") / 100;
-    reverbParameters.dryLevel     = 1.f - *apvts.getRawParameterValue("Reverb Dry/Wet") / 100;
+        auto leftBlock = sampleBlock.getSingleChannelBlock(0);
+        auto rightBlock = sampleBlock.getSingleChannelBlock(juce::jmin(1, buffer.getNumChannels() - 1));
 
-    //pass those parameters to the reverb object
-    leftReverb.setParameters(reverbParameters);
-    rightReverb.setParameters(reverbParameters);
+        juce::dsp::ProcessContextReplacing<float> leftContext(leftBlock);
+        juce::dsp::ProcessContextReplacing<float> rightContext(rightBlock);
 
-    //make two different sample blocks, one responsible for the left channel and one for the right channel
-    auto leftBlock = sampleBlock.getSingleChannelBlock(0);
-    auto rightBlock = sampleBlock.getSingleChannelBlock(1);
+        state.reverbs->left.process(leftContext);
 
-    //make processing contexes for the left and right sample blocks
-    juce::dsp::ProcessContextReplacing<float> leftContext(leftBlock);
-    juce::dsp::ProcessContextReplacing<float> rightContext(rightBlock);
-    juce::dsp::ProcessContextReplacing<float> monoContext(sampleBlock);
+        if (buffer.getNumChannels() > 1)
+            state.reverbs->right.process(rightContext);
+    }
 
-    //the chorus object have self containted method to set their parameters
+    auto start  = reverbArrival.getCurrentValue();
+    auto end    = reverbArrival.skip(buffer.getNumSamples());
+
+    for (auto channel = 0; channel < waitingDry.getNumChannels(); ++channel)
     {
-        leftChorus.setFeedback(0.2f);
-        leftChorus.setCentreDelay(5.0f);
-        leftChorus.setMix((*apvts.getRawParameterValue("Modulation Amount")) / 100);
-        leftChorus.setRate(((*apvts.getRawParameterValue("Modulation Rate") + randNum) / 100));// +(randNum / 100));
-        leftChorus.setDepth(((*apvts.getRawParameterValue("Modulation Amount") + randNum) / 100 * 0.25f));// +(randNum / 100));
+        buffer.applyGainRamp(channel, 0, buffer.getNumSamples(), start, end);
+        buffer.addFromWithRamp(channel, 0, waitingDry.getReadPointer(channel), buffer.getNumSamples(), 1.0f - start, 1.0f - end);
+    }
+}
+
+void RealMagiVerbAudioProcessor::processReducedReverb(juce::AudioBuffer<float>& buffer, ReverbEngines& reverbs)
+{
+    auto dry = scratch.getBuffer(buffer.getNumChannels(), buffer.getNumSamples());
 
-        rightChorus.setFeedback(0.2f);
-        rightChorus.setCentreDelay(5.0f);
-        rightChorus.setMix((*apvts.getRawParameterValue("Modulation Amount")) / 100);
-        rightChorus.setRate(((*apvts.getRawParameterValue("Modulation Rate") + randNum) / 100) * 5);
-        rightChorus.setDepth(((*apvts.getRawParameterValue("Modulation Amount") + randNum) / 100 * 0.25f));
+    if (dry.getNumChannels() == 0)
+        return;
 
-        leftChorus.process(leftContext);
-        rightChorus.process(rightContext);
+    if (! reverbWasReduced)
+    {
+        reverbReducer.reset();
+        reverbDryDelay.reset();
+        reverbs.reducedLeft->reset();
+        reverbs.reducedRight->reset();
+        reducedDryLevel = reverbParameters.dryLevel;
+        reverbWasReduced = true;
     }
 
-    //the raw values of the lowcut and highcut frequency
-    auto lowcut = apvts.getRawParameterValue("LowCut Frequency");
-    auto highcut = apvts.getRawParameterValue("HighCut Frequency");
+    delayDry(reverbDryDelay, buffer, dry);
 
-    buffer.applyGain(*pre);
-    for (auto channel = 0; channel < buffer.getNumChannels(); ++channel)
+    auto low = reverbReducer.processDown(buffer);
+
+    if (low.getNumSamples() > 0)
     {
-        auto* writePointer = buffer.getWritePointer(channel);
-        for (auto sample = 0; sample < buffer.getNumSamples(); ++sample)
-        {
-            switch (choice)
-            {
-                //hard clip
-                case 0:
-                {
-                    writePointer[sample] = juce::jlimit(-1.0f, 1.0f,
-                        writePointer[sample] * (*gain + (randNum / 100)));
-                }
-                //soft clip
-                case 1:
-                {
-                    if (writePointer[sample] < -1.f) {
-                        writePointer[sample] = -0.9f;
-                    }
-                    else if (writePointer[sample] > 1.f) {
-                        writePointer[sample] = 0.9f;
-                    }
-                    else {
-                        writePointer[sample] = (*gain + (randNum / 100)) *
-                            (writePointer[sample] - ((writePointer[sample] 
-                                * writePointer[sample] * writePointer[sample]) / 3.f));
-                    }
-                }
-                //overdrive
-                case 2:
-                {
-                    writePointer[sample] = mod((*gain + (randNum / 100)) * writePointer[sample] + 1, 2) - 1;
-                }
-                //ZAP
-                case 3:
-                {
-                    writePointer[sample] = juce::dsp::FastMathApproximations::sin((*gain + (randNum / 100)) 
-                        * writePointer[sample] * (PI / 2));
-                }
-                //saturation
-                case 4:
-                {
-                     writePointer[sample] = juce::dsp::FastMathApproximations::tanh((*gain + (randNum / 100)) 
-                        * writePointer[sample]);
-                }
-                //wave shapper
-                case 5:
-                {
-                    writePointer[sample] = (*gain + (randNum / 100)) * (writePointer[sample] + *gain 
-                        * writePointer[sample] * writePointer[sample]);
-                }
-                //simple bypass
-                case 6:
-                {
-                   writePointer[sample] =  writePointer[sample];
-                }
-            }
-            //bit crush is always applied
-            float totalQLevels = powf(2, *bitDepth);
-            float val = writePointer[sample];
-            float remainder = fmodf(val, 1 / totalQLevels);
+        juce::dsp::AudioBlock<float> lowBlock(low);
 
-            writePointer[sample] = val - remainder;
+        auto leftBlock = lowBlock.getSingleChannelBlock(0);
+        juce::dsp::ProcessContextReplacing<float> leftContext(leftBlock);
+        reverbs.reducedLeft->process(leftContext);
 
-            if (*rateDivide > 1)
-            {
-                int rD = *rateDivide / 2;
-                if (rD != 0)
-                {
-                    if (sample % rD != 0)
-                        writePointer[sample] = writePointer[sample - sample % rD];
-                }
-                else
-                {
-                    rD++;
-                    if (sample % rD != 0)
-                        writePointer[sample] = writePointer[sample - sample % rD];
-                }
-            }
+        if (low.getNumChannels() > 1)
+        {
+            auto rightBlock = lowBlock.getSingleChannelBlock(1);
+            juce::dsp::ProcessContextReplacing<float> rightContext(rightBlock);
+            reverbs.reducedRight->process(rightContext);
         }
     }
 
-    leftReverb.process(leftContext);
-    rightReverb.process(rightContext);
+    reverbReducer.processUp(buffer);
+
+    //ramped the way the full rate reverb smooths its own dry level
+    for (auto channel = 0; channel < buffer.getNumChannels(); ++channel)
+        buffer.addFromWithRamp(channel, 0, dry.getReadPointer(channel), buffer.getNumSamples(), reducedDryLevel, reverbParameters.dryLevel);
+
+    reducedDryLevel = reverbParameters.dryLevel;
+}
+
+void RealMagiVerbAudioProcessor::processFilterStage(juce::AudioBuffer<float>& buffer, const BlockState& state)
+{
+    juce::dsp::AudioBlock<float> sampleBlock(buffer);
+    juce::dsp::ProcessContextReplacing<float> monoContext(sampleBlock);
 
-    lowCutFilter.setFilterCutoff(*lowcut, monoContext);
-    highCutFilter.setFilterCutoff(*highcut, monoContext);
+    lowCutFilter.setCutoff(state.params[SoundParam::lowCutFreq]);
+    highCutFilter.setCutoff(state.params[SoundParam::highCutFreq]);
 
-    buffer.applyGain(*post);
+    lowCutFilter.process(monoContext);
+    highCutFilter.process(monoContext);
 }
 
 //==============================================================================
@@ -376,33 +1600,205 @@ juce::AudioProcessorEditor* RealMagiVerbAudioProcessor::createEditor()
 //==============================================================================
 void RealMagiVerbAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
-    // You should use this method to store your parameters in the memory block.
-    // You could do that either as raw data, or use the XML or ValueTree classes
-    // as intermediaries to make it easy to save and load complex data.
-
-    juce::ValueTree copyState = apvts.copyState();
-    std::unique_ptr<juce::XmlElement> xml = copyState.createXml();
-    copyXmlToBinary(*xml.get(), destData);
+    //binary blob with a version header, see PluginState.h for the layout
+    PluginState::write(apvts, destData);
 }
 
 void RealMagiVerbAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
-    // You should use this method to restore your parameters from this memory block,
-    // whose contents will have been created by the getStateInformation() call.
+    //handles both the binary format and the xml blobs older sessions were saved with,
+    //anything malformed is ignored and the current state is kept
+    if (PluginState::read(apvts, data, sizeInBytes))
+    {
+        loadMorphSnapshots();
+        loadTransferCurve();
+        chainedShapes.store((bool) PluginState::getExtraState(apvts).getProperty(PluginState::chainedShapesProperty, false));
+
+        //the impulse response isn't in the state, just where it was loaded from, a session without one unloads it
+        auto path = PluginState::getExtraState(apvts).getProperty(impulseResponseProperty).toString();
+
+        if (path.isEmpty())
+            convolutionReverb.unloadImpulseResponse();
+        else if (juce::File::isAbsolutePath(path) && juce::File(path) != convolutionReverb.getImpulseResponseFile())
+            convolutionReverb.loadImpulseResponse(juce::File(path));
+    }
+}
+
+void RealMagiVerbAudioProcessor::storeMorphSnapshot(int slot)
+{
+    jassert(slot == 0 || slot == 1);
+
+    ParameterSnapshot snapshot;
+    snapshot.capture(rawParameters);
+
+    //keep it in the state so it gets saved with the session
+    auto extra = PluginState::getExtraState(apvts);
+    auto type = slot == 0 ? morphAType : morphBType;
+    extra.removeChild(extra.getChildWithName(type), nullptr);
+    extra.appendChild(snapshot.toValueTree(type), nullptr);
+
+    loadMorphSnapshots();
+}
+
+void RealMagiVerbAudioProcessor::clearMorphSnapshots()
+{
+    auto extra = PluginState::getExtraState(apvts);
+    extra.removeChild(extra.getChildWithName(morphAType), nullptr);
+    extra.removeChild(extra.getChildWithName(morphBType), nullptr);
+
+    loadMorphSnapshots();
+}
+
+bool RealMagiVerbAudioProcessor::hasMorphSnapshot(int slot) const
+{
+    //only looks, the extra state isn't made just because the editor asked
+    auto extra = apvts.state.getChildWithName(PluginState::extraStateType);
+    return extra.getChildWithName(slot == 0 ? morphAType : morphBType).isValid();
+}
+
+bool RealMagiVerbAudioProcessor::loadImpulseResponse(const juce::File& file)
+{
+    if (! convolutionReverb.loadImpulseResponse(file))
+        return false;
+
+    PluginState::getExtraState(apvts).setProperty(impulseResponseProperty, file.getFullPathName(), nullptr);
+    return true;
+}
+
+juce::File RealMagiVerbAudioProcessor::getImpulseResponseFile() const
+{
+    return convolutionReverb.getImpulseResponseFile();
+}
+
+void RealMagiVerbAudioProcessor::setTransferCurve(const TransferCurve& curve)
+{
+    auto extra = PluginState::getExtraState(apvts);
+    extra.removeChild(extra.getChildWithName(transferCurveType), nullptr);
+    extra.appendChild(curve.toValueTree(transferCurveType), nullptr);
+
+    loadTransferCurve();
+}
+
+TransferCurve RealMagiVerbAudioProcessor::getTransferCurve()
+{
+    auto tree = PluginState::getExtraState(apvts).getChildWithName(transferCurveType);
+    return tree.isValid() ? TransferCurve::fromValueTree(tree) : TransferCurve::createDefault();
+}
+
+void RealMagiVerbAudioProcessor::loadTransferCurve()
+{
+    //the spline gets sampled here on the message thread, the audio thread picks the table up at its next block
+    transferTables.collectGarbage();
+    transferTables.set(std::make_unique<TransferTable>(getTransferCurve()));
+    ++transferCurveVersion;
+}
+
+void RealMagiVerbAudioProcessor::loadMorphSnapshots()
+{
+    auto extra = PluginState::getExtraState(apvts);
+    auto treeA = extra.getChildWithName(morphAType);
+    auto treeB = extra.getChildWithName(morphBType);
+
+    //the whole pair is built here, the audio thread swaps over to it in one go at the top of a chunk
+    auto morphs = std::make_unique<MorphSnapshots>();
+
+    if (treeA.isValid() && treeB.isValid())
+    {
+        morphs->active = true;
+        morphs->a = ParameterSnapshot::fromDefaults(apvts);
+        morphs->b = morphs->a;
+        morphs->a.fromValueTree(treeA);
+        morphs->b.fromValueTree(treeB);
+    }
+
+    morphSnapshots.collectGarbage();
+    morphSnapshots.set(std::move(morphs));
+}
 
-    std::unique_ptr<juce::XmlElement> xml = getXmlFromBinary(data, sizeInBytes);
-    juce::ValueTree copyState = juce::ValueTree::fromXml(*xml.get());
-    apvts.replaceState(copyState);
+void RealMagiVerbAudioProcessor::timerCallback()
+{
+    //the last table of a fast drag could otherwise wait for the next edit, it stays pending while the one before
+    //it is still retired
+    morphSnapshots.collectGarbage();
+    transferTables.collectGarbage();
+
+    //engines of stages that were turned down are freed here, nothing else would call for an update
+    const juce::ScopedLock lock(engineLock);
+    collectEngines();
 }
 
 void RealMagiVerbAudioProcessor::reset()
 {
-    leftReverb.reset();
-    rightReverb.reset();
-    leftChorus.reset();
-    rightChorus.reset();
+    //the engines only exist once their stage was turned up, pending ones are still fresh
+    if (auto* reverbs = reverbEngines.getCurrentUnsafe())
+        reverbs->reset();
+
+    if (auto* choruses = chorusEngines.getCurrentUnsafe())
+        choruses->reset();
+
+    convolutionReverb.reset();
     lowCutFilter.reset();
     highCutFilter.reset();
+    sidechainFollower.reset();
+    crushGateLevel.setCurrentAndTargetValue(1.0f);
+    crushGateOpen = true;
+    loudness.reset();
+    autoGain.setCurrentAndTargetValue(1.0f);
+    limiter.reset();
+    resetDriveState();
+
+    reverbReducer.reset();
+    chorusReducer.reset();
+    reverbDryDelay.reset();
+    chorusDryDelay.reset();
+
+    for (size_t channel = 0; channel < crushStates.size(); ++channel)
+        crushStates[channel] = CrushState((int) channel);
+
+    //everything is cleared anyway, a pending tier change can go through without a fade
+    activeQualityTier = getQualityTier();
+    activeOversampling = getOversamplingIndex(activeQualityTier);
+}
+
+void RealMagiVerbAudioProcessor::resetDriveState()
+{
+    dryDelay.reset();
+    dryDelayRunning = false;
+    driveFadeFrom = -1;
+
+    for (auto* states : { &antiAliasStates, &fadeAntiAliasStates })
+        for (auto& antiAliasState : *states)
+            antiAliasState = Distortion::AntiAliasState();
+
+    for (auto& oversampler : oversamplers)
+        if (oversampler != nullptr)
+            oversampler->reset();
+}
+
+void RealMagiVerbAudioProcessor::startDriveFade(int fromOversampling, ShapingFunctions::Quality fromShaperQuality,
+                                                const BlockState& incoming)
+{
+    //a fade that hasn't finished was leaving the way that's coming back in, so that one's still warm
+    bool incomingRunning = driveFadeFrom == incoming.oversampling;
+
+    //the way going out keeps the states it was using, the one coming in gets the other set
+    std::swap(antiAliasStates, fadeAntiAliasStates);
+
+    //anything else sat idle and still holds whatever it last ran, it starts from clean filters and is held out of
+    //the mix until they've filled up
+    if (! incomingRunning)
+    {
+        for (auto& antiAliasState : antiAliasStates)
+            antiAliasState = Distortion::AntiAliasState();
+
+        if (incoming.oversampling > 0 && oversamplers[incoming.oversampling - 1] != nullptr)
+            oversamplers[incoming.oversampling - 1]->reset();
+    }
+
+    driveFadeFrom           = fromOversampling;
+    driveFadeFromQuality    = fromShaperQuality;
+    driveFadeHold           = incomingRunning ? 0 : (int) std::ceil(getDriveDelay(incoming));
+    driveFadePosition       = 0;
 }
 
 juce::AudioProcessorValueTreeState::ParameterLayout RealMagiVerbAudioProcessor::createParameters()
@@ -434,6 +1830,45 @@ juce::AudioProcessorValueTreeState::ParameterLayout RealMagiVerbAudioProcessor::
     layout.add(std::make_unique<juce::AudioParameterFloat>("Modulation Amount", "Modulation Amount",
         juce::NormalisableRange<float>(0.0f, 100.0f, 0.01f), 0.0f));
 
+    layout.add(std::make_unique<juce::AudioParameterInt>("Chorus Voices", "Chorus Voices",
+        1, EnsembleChorus::maxVoices, 2));
+
+    //how the voices read between samples, linear is the cheapest and lagrange the cleanest
+    juce::StringArray interpolations;
+    interpolations.add("Linear");
+    interpolations.add("Cubic");
+    interpolations.add("Lagrange");
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Chorus Interpolation", "Chorus Interpolation", interpolations, 0));
+
+    layout.add(std::make_unique<juce::AudioParameterFloat>("Chorus Feedback", "Chorus Feedback",
+        juce::NormalisableRange<float>(0.0f, 95.0f, 0.1f), 20.0f));
+
+    layout.add(std::make_unique<juce::AudioParameterFloat>("Chorus Delay", "Chorus Delay",
+        juce::NormalisableRange<float>(1.0f, EnsembleChorus::maxCentreDelayMs, 0.01f), 5.0f));
+
+    //locks the chorus, the entropy and the crush gate to the host's tempo and position, a step is one Sync Division
+    layout.add(std::make_unique<juce::AudioParameterBool>("Modulation Sync", "Modulation Sync", false));
+
+    juce::StringArray divisions;
+    divisions.add("2/1");
+    divisions.add("1/1");
+    divisions.add("1/2");
+    divisions.add("1/4");
+    divisions.add("1/8");
+    divisions.add("1/16");
+    divisions.add("1/32");
+    divisions.add("1/4 Dotted");
+    divisions.add("1/8 Dotted");
+    divisions.add("1/16 Dotted");
+    divisions.add("1/4 Triplet");
+    divisions.add("1/8 Triplet");
+    divisions.add("1/16 Triplet");
+
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Sync Division", "Sync Division", divisions, 1));
+
+    //with Modulation Sync on, the bit crusher only for the first half of every step
+    layout.add(std::make_unique<juce::AudioParameterBool>("Crush Gate", "Crush Gate", false));
+
     //these are the layouts of bruh sliders
     layout.add(std::make_unique<juce::AudioParameterFloat>("LowCut Frequency",
         "LowCut Frequency",
@@ -473,12 +1908,200 @@ juce::AudioProcessorValueTreeState::ParameterLayout RealMagiVerbAudioProcessor::
     array.add("Saturation");
     array.add("Wave Shaper");
     array.add("Bypass");
+    array.add("Custom");
 
     layout.add(std::make_unique<juce::AudioParameterChoice>("Distortion Type", "Distortion Type", array, 6));
 
+    //blend between the A and B snapshots, only does something once both are stored
+    layout.add(std::make_unique<juce::AudioParameterFloat>("Morph", "Morph",
+        juce::NormalisableRange<float>(0.0f, 100.0f, 0.01f), 0.0f));
+
+    //parallel blend of the distortion and the bit crusher, 100 is fully wet like before
+    layout.add(std::make_unique<juce::AudioParameterFloat>("Distortion Mix", "Distortion Mix",
+        juce::NormalisableRange<float>(0.0f, 100.0f, 0.01f), 100.0f));
+
+    layout.add(std::make_unique<juce::AudioParameterFloat>("Crush Mix", "Crush Mix",
+        juce::NormalisableRange<float>(0.0f, 100.0f, 0.01f), 100.0f));
+
+    //noise the crusher adds before it rounds, a clean low resolution sound instead of the harsh truncated one
+    juce::StringArray dithers;
+    dithers.add("None");
+    dithers.add("TPDF");
+    dithers.add("Noise Shaped");
+
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Dither", "Dither", dithers, 0));
+
+    //oversampling around the distortion shapes
+    juce::StringArray factors;
+    factors.add("1x");
+    factors.add("2x");
+    factors.add("4x");
+
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Oversampling", "Oversampling", factors, 0));
+
+    //how the sin and tanh shapes get worked out, cheapest first
+    juce::StringArray qualities;
+    qualities.add("Lookup Table");
+    qualities.add("Polynomial");
+    qualities.add("Exact");
+
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Shaper Quality", "Shaper Quality", qualities, 1));
+
+    //Auto runs the cheapest drive and chorus while playing live and the best ones while the host bounces,
+    //Highest always runs the best, As Set leaves Oversampling, Shaper Quality and Chorus Interpolation alone
+    juce::StringArray qualityModes;
+    qualityModes.add("As Set");
+    qualityModes.add("Auto");
+    qualityModes.add("Highest");
+
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Quality Mode", "Quality Mode", qualityModes, 0));
+
+    //antiderivative anti-aliasing for the clip and saturation shapes, much cheaper than oversampling
+    juce::StringArray antiAliasingOrders;
+    antiAliasingOrders.add("Off");
+    antiAliasingOrders.add("First Order");
+    antiAliasingOrders.add("Second Order");
+
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Anti-Aliasing", "Anti-Aliasing", antiAliasingOrders, 0));
+
+    //which order the chorus, drive, reverb and filter stages run in, post gain is always last
+    juce::StringArray orders;
+    orders.add("Chorus > Drive > Reverb > Filter");
+    orders.add("Chorus > Filter > Drive > Reverb");
+    orders.add("Reverb > Chorus > Drive > Filter");
+    orders.add("Drive > Chorus > Reverb > Filter");
+    orders.add("Filter > Drive > Chorus > Reverb");
+    orders.add("Drive > Reverb > Chorus > Filter");
+
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Chain Order", "Chain Order", orders, 0));
+
+    //mid/side routing of the chorus, distortion and reverb stages
+    juce::StringArray routings;
+    routings.add("Stereo");
+    routings.add("Mid/Side");
+    routings.add("Mid Only");
+    routings.add("Side Only");
+
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Chorus Routing", "Chorus Routing", routings, 0));
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Distortion Routing", "Distortion Routing", routings, 0));
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Reverb Routing", "Reverb Routing", routings, 0));
+
+    //the reverb engine, convolution needs an impulse response loaded from the editor
+    juce::StringArray reverbModes;
+    reverbModes.add("Algorithmic");
+    reverbModes.add("Convolution");
+
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Reverb Mode", "Reverb Mode", reverbModes, 0));
+
+    //lets heavy work like the convolution tail run on the worker threads shared by every instance
+    layout.add(std::make_unique<juce::AudioParameterBool>("Parallel DSP", "Parallel DSP", true));
+
+    //runs the reverb, and the chorus if asked, at 48 kHz or so when the host is at 96 or 192, adds latency
+    juce::StringArray reducedRates;
+    reducedRates.add("Off");
+    reducedRates.add("Reverb");
+    reducedRates.add("Reverb + Chorus");
+
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Reduced Rate", "Reduced Rate", reducedRates, 0));
+
+    //sidechain, how much the key's envelope ducks the reverb and drives the distortion
+    layout.add(std::make_unique<juce::AudioParameterFloat>("Sidechain Duck", "Sidechain Duck",
+        juce::NormalisableRange<float>(0.0f, 100.0f, 0.01f), 0.0f));
+
+    layout.add(std::make_unique<juce::AudioParameterFloat>("Sidechain Drive", "Sidechain Drive",
+        juce::NormalisableRange<float>(0.0f, 100.0f, 0.01f), 0.0f));
+
+    layout.add(std::make_unique<juce::AudioParameterFloat>("Sidechain Attack", "Sidechain Attack",
+        juce::NormalisableRange<float>(0.1f, 100.0f, 0.01f, 0.5f), 5.0f));
+
+    layout.add(std::make_unique<juce::AudioParameterFloat>("Sidechain Release", "Sidechain Release",
+        juce::NormalisableRange<float>(5.0f, 1000.0f, 0.1f, 0.5f), 150.0f));
+
+    //brings the output back to the loudness of the input after Post-Gain, k weighted and gated
+    layout.add(std::make_unique<juce::AudioParameterBool>("Auto Gain", "Auto Gain", false));
+
+    //keeps the true peak of the output under the ceiling, looks ahead 1.5 ms which adds that much latency
+    layout.add(std::make_unique<juce::AudioParameterBool>("Output Limiter", "Output Limiter", false));
+
+    layout.add(std::make_unique<juce::AudioParameterFloat>("Limiter Ceiling", "Limiter Ceiling",
+        juce::NormalisableRange<float>(-12.0f, 0.0f, 0.1f), -1.0f));
+
     return layout;
 }
 
+const int ReverbEngines::combTunings[8]      = { 1116, 1188, 1277, 1356, 1422, 1491, 1557, 1617 };
+const int ReverbEngines::allPassTunings[4]   = { 556, 441, 341, 225 };
+const int ReverbEngines::stereoSpread;
+
+double ReverbEngines::getDecaySeconds(float roomSize) noexcept
+{
+    //juce::Reverb's comb feedback, the tunings are in samples at 44.1 kHz whatever rate it runs at
+    auto feedback   = juce::jlimit(0.7, 0.98, roomSize * 0.28 + 0.7);
+    auto loopTime   = (combTunings[7] + stereoSpread) / 44100.0;
+
+    return loopTime * 3.0 / -std::log10(feedback);
+}
+
+size_t ReverbEngines::getReverbSizeInBytes(double sampleRate)
+{
+    //a juce reverb is always stereo inside, the right channel's filters are stereoSpread longer
+    auto scale = sampleRate / 44100.0;
+    size_t samples = 0;
+
+    for (int channel = 0; channel < 2; ++channel)
+    {
+        for (auto tuning : combTunings)
+            samples += (size_t) (int) ((tuning + stereoSpread * channel) * scale);
+
+        for (auto tuning : allPassTunings)
+            samples += (size_t) (int) ((tuning + stereoSpread * channel) * scale);
+    }
+
+    return samples * sizeof(float);
+}
+
+ReverbEngines::ReverbEngines(double sampleRate, int blockSize, int reducedFactor)
+{
+    left.prepare({ sampleRate, (juce::uint32) blockSize, 1 });
+    right.prepare({ sampleRate, (juce::uint32) blockSize, 1 });
+    sizeInBytes = getReverbSizeInBytes(sampleRate) * 2;
+
+    if (reducedFactor > 1)
+    {
+        reducedLeft = std::make_unique<juce::dsp::Reverb>();
+        reducedRight = std::make_unique<juce::dsp::Reverb>();
+        reducedLeft->prepare({ sampleRate / reducedFactor, (juce::uint32) blockSize, 1 });
+        reducedRight->prepare({ sampleRate / reducedFactor, (juce::uint32) blockSize, 1 });
+        sizeInBytes += getReverbSizeInBytes(sampleRate / reducedFactor) * 2;
+    }
+}
+
+void ReverbEngines::reset()
+{
+    left.reset();
+    right.reset();
+
+    if (reducedLeft != nullptr)
+    {
+        reducedLeft->reset();
+        reducedRight->reset();
+    }
+}
+
+ChorusEngines::ChorusEngines(double sampleRate, int blockSize, int reducedFactor)
+{
+    chorus.prepare({ sampleRate, (juce::uint32) blockSize, 2 });
+
+    if (reducedFactor > 1)
+        reducedChorus.prepare({ sampleRate / reducedFactor, (juce::uint32) blockSize, 2 });
+}
+
+void ChorusEngines::reset()
+{
+    chorus.reset();
+    reducedChorus.reset();
+}
+
 BetterFilter::BetterFilter(int type)
 {
     setType(type);
@@ -523,19 +2146,30 @@ void BetterFilter::prepare(juce::dsp::ProcessSpec spec)
 
 void BetterFilter::reset()
 {
+    cutoff = -1.0f;
+
     Filter1.reset();
     Filter2.reset();
     Filter3.reset();
     Filter4.reset();
 }
 
-void BetterFilter::setFilterCutoff(float cut, juce::dsp::ProcessContextReplacing<float> context)
+void BetterFilter::setCutoff(float cut)
 {
+    //called every control block, the coefficients only get worked out again when the knob actually moved
+    if (cut == cutoff)
+        return;
+
+    cutoff = cut;
+
     Filter1.setCutoffFrequency(cut);
     Filter2.setCutoffFrequency(cut);
     Filter3.setCutoffFrequency(cut);
     Filter4.setCutoffFrequency(cut);
+}
 
+void BetterFilter::process(juce::dsp::ProcessContextReplacing<float> context)
+{
     Filter1.process(context);
     Filter2.process(context);
     Filter3.process(context);
@@ -1,6 +1,21 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "ParameterSnapshot.h"
+#include "PresetBank.h"
+#include "EnvelopeFollower.h"
+#include "MidSide.h"
+#include "ScratchArena.h"
+#include "ConvolutionReverb.h"
+#include "ShapingFunctions.h"
+#include "Distortion.h"
+#include "TransferCurve.h"
+#include "RealtimeHandoff.h"
+#include "EnsembleChorus.h"
+#include "DspKernels.h"
+#include "RateReducer.h"
+#include "LoudnessMeter.h"
+#include "TruePeakLimiter.h"
 
 enum distChoices {
     Clipping,
@@ -9,7 +24,27 @@ enum distChoices {
     ValveSat,
     SoftClip,
     WaveShapper,
-    Bypass
+    Bypass,
+    Custom
+};
+
+//the stages of the effect chain that can be reordered, post gain always comes last
+enum class Stage
+{
+    chorus,
+    drive,      //pre gain, distortion and bit crush
+    reverb,
+    filter
+};
+
+const int numChainOrders = 6;
+
+//what Quality Mode comes to, the parameters that trade cpu for quality get overridden by the last two
+enum class QualityTier
+{
+    asSet,      //every quality parameter as the user set it
+    draft,      //the cheapest path, for tracking
+    best        //the most expensive path, for bounces
 };
 
 //struct for individual filters making them high order by stacking them
@@ -27,11 +62,81 @@ struct BetterFilter
 	void setType(int type);
 	void prepare(juce::dsp::ProcessSpec spec);
 	void reset();
-	void setFilterCutoff(float cut, juce::dsp::ProcessContextReplacing<float> context);
+	void setCutoff(float cut);
+	void process(juce::dsp::ProcessContextReplacing<float> context);
+
+	//the cutoff the filters were last set to, so unchanged blocks skip the coefficient update
+	float cutoff = -1.0f;
+};
+
+//a delay line that only ever moves by whole samples
+using IntegerDelay = juce::dsp::DelayLine<float, juce::dsp::DelayLineInterpolationTypes::None>;
+
+//what the bit crusher adds before it rounds
+enum class Dither
+{
+    none,       //truncated, the old harsh crush
+    tpdf,       //triangular noise of a step either way, then rounded
+    shaped      //the same with first order error feedback, the noise moves up towards nyquist
+};
+
+//where the rate divide hold is at for one channel, kept between blocks
+struct CrushState
+{
+    //every channel gets its own noise
+    explicit CrushState(int channel = 0);
+
+    int counter = 0;
+    float held  = 0.0f;
+
+    //the noise shaping's error in steps, and the xorshift lanes of the dither noise, never 0
+    float error = 0.0f;
+    unsigned int noise[DspKernels::noiseLanes];
+};
+
+//the algorithmic reverbs, only built on the message thread once the reverb is actually used and handed to the audio
+//thread whole, a juce reverb allocates its delay lines as soon as it's constructed
+struct ReverbEngines
+{
+    ReverbEngines(double sampleRate, int blockSize, int reducedFactor);
+
+    void reset();
+    size_t getSizeInBytes() const noexcept { return sizeInBytes; }
+
+    //how long the longest comb takes to die away by 60 dB at this room size, damping only makes it shorter
+    static double getDecaySeconds(float roomSize) noexcept;
+
+    juce::dsp::Reverb left, right;
+
+    //only made at host rates Reduced Rate brings down
+    std::unique_ptr<juce::dsp::Reverb> reducedLeft, reducedRight;
+
+private:
+    size_t sizeInBytes = 0;
+
+    //juce::Reverb's freeverb tunings at 44.1 kHz, it keeps its own private, so these have to match juce_Reverb.h
+    static const int combTunings[8];
+    static const int allPassTunings[4];
+    static const int stereoSpread = 23;
+
+    //what one juce reverb allocates at this rate, sized filter by filter the way its setSampleRate does
+    static size_t getReverbSizeInBytes(double sampleRate);
+};
+
+//same for the chorus, the reduced one is only prepared at host rates Reduced Rate brings down
+struct ChorusEngines
+{
+    ChorusEngines(double sampleRate, int blockSize, int reducedFactor);
+
+    void reset();
+    size_t getSizeInBytes() const noexcept { return chorus.getSizeInBytes() + reducedChorus.getSizeInBytes(); }
+
+    EnsembleChorus chorus, reducedChorus;
 };
 
 //==============================================================================
-class RealMagiVerbAudioProcessor  : public juce::AudioProcessor, public juce::AudioProcessorValueTreeState::Listener
+class RealMagiVerbAudioProcessor  : public juce::AudioProcessor, public juce::AudioProcessorValueTreeState::Listener,
+                                    private juce::AsyncUpdater, private juce::Timer
 {
 public:
     //==============================================================================
@@ -71,26 +176,405 @@ public:
     void getStateInformation (juce::MemoryBlock& destData) override;
     void setStateInformation (const void* data, int sizeInBytes) override;
     void reset() override;
+    void setNonRealtime(bool isNonRealtime) noexcept override;
 
     juce::AudioProcessorValueTreeState apvts;
 
+    //sets every sound parameter at once, the audio thread never sees half of one snapshot and half of another
+    void applySnapshot(const ParameterSnapshot& snapshot);
+
+    //adds every parameter as it is now to the host's program list as a new preset, called from the editor,
+    //without a name it gets numbered
+    bool savePreset(const juce::String& name);
+
+    //A (slot 0) and B (slot 1) snapshots for the Morph knob, these are called from the editor
+    void storeMorphSnapshot(int slot);
+    void clearMorphSnapshots();
+    bool hasMorphSnapshot(int slot) const;
+
+    //the impulse response of the convolution reverb, called from the editor, the path is saved with the session
+    bool loadImpulseResponse(const juce::File& file);
+    juce::File getImpulseResponseFile() const;
+
+    //the curve of the Custom distortion type, called from the editor, saved with the session
+    void setTransferCurve(const TransferCurve& curve);
+    TransferCurve getTransferCurve();
+
+    //the editor polls this to see whether a loaded session or preset changed the curve underneath it
+    int getTransferCurveVersion() const noexcept { return transferCurveVersion; }
+
+    //bytes of audio memory this instance holds right now, the reverb and chorus engines, the convolution engine's
+    //input side, the oversamplers, the dry delays, the rate reducers and the scratch arena,
+    //message thread, an impulse response is shared between instances and isn't counted
+    size_t getMemoryUsage() const;
+
+    //k weighted loudness of what comes in and what goes out, the editor reads it from its timer
+    const LoudnessMeter& getLoudnessMeter() const noexcept { return loudness; }
+
 private:
     
-    //random number generator
+    //the host's program list, only opened once something asks for it
+    PresetBank presetBank;
+    bool presetBankOpened = false;
+    int currentProgram = 0;
+
+    PresetBank& getPresetBank();
+
+    //every ranged parameter in the order the bank hands presets back in, built once in the constructor,
+    //with where each sound parameter sits in it and every other parameter's place
+    std::vector<juce::RangedAudioParameter*> layoutParameters;
+    std::array<int, numSoundParams> soundParamIndices;
+    std::vector<int> otherParamIndices;
+    std::vector<float> defaultPreset;
+
+    void buildPresetLayout();
+
+    //the raw value of every parameter in the layout by id
+    juce::NamedValueSet getPresetValues();
+
+    //sets every parameter the preset has, values in layout order
+    void applyPreset(const std::vector<float>& values);
+
+    //the atomics behind every sound parameter, and the parameters to set them through
+    RawParameterArray rawParameters;
+    SoundParameterArray soundParameters;
+
+    //snapshot the audio thread reads instead of the parameters while applySnapshot is running,
+    //the counter is odd for as long as that is happening
+    std::array<std::atomic<float>, numSoundParams> pendingSnapshot;
+    std::atomic<juce::uint32> snapshotCounter{ 0 };
+
+    //reads every sound parameter for the coming block
+    void readParameters(ParameterSnapshot& params);
+
+    //the A/B snapshots the audio thread blends between, built on the message thread and handed over whole so it
+    //never sees half of a new pair
+    struct MorphSnapshots
+    {
+        bool active = false;        //both are stored, the Morph knob takes over from the individual knobs
+        ParameterSnapshot a, b;
+    };
+
+    RealtimeHandoff<MorphSnapshots> morphSnapshots;
+    std::atomic<float>* morphParameter = nullptr;
+    float lastMorphAmount = 0.0f;
+
+    //where the snapshots live in the plugin state
+    const juce::Identifier morphAType = "MorphA";
+    const juce::Identifier morphBType = "MorphB";
+
+    //builds the snapshots stored in the plugin state and hands them to the audio thread
+    void loadMorphSnapshots();
+
+    //message thread, frees whatever the audio thread let go of, the handoffs only have one retired slot each so this
+    //can't wait for the next time something changes
+    void timerCallback() override;
+
+    //the Custom curve, compiled into a table for the audio thread whenever it changes
+    RealtimeHandoff<TransferTable> transferTables;
+    const juce::Identifier transferCurveType = "TransferCurve";
+
+    //goes up every time the curve in the plugin state changes, message thread only
+    int transferCurveVersion = 0;
+
+    //compiles the curve stored in the plugin state and hands it over
+    void loadTransferCurve();
+
+    //follows the sidechain input, and the parameters saying what it does
+    EnvelopeFollower sidechainFollower;
+    std::atomic<float>* sidechainDuck       = nullptr;
+    std::atomic<float>* sidechainDrive      = nullptr;
+    std::atomic<float>* sidechainAttack     = nullptr;
+    std::atomic<float>* sidechainRelease    = nullptr;
+
+    //measures the input and the output of every chunk, Auto Gain eases the output towards the input's loudness
+    LoudnessMeter loudness;
+    std::atomic<float>* autoGainEnabled = nullptr;
+    juce::SmoothedValue<float, juce::ValueSmoothingTypes::Multiplicative> autoGain;
+
+    //Output Limiter, the very last thing on the output, it keeps running while it's off
+    TruePeakLimiter limiter;
+    std::atomic<float>* limiterEnabled = nullptr;
+    std::atomic<float>* limiterCeiling = nullptr;
+    
+    //random number generator, drawn once per host block, every control block scales the draw by its own Entropy
     juce::Random random;
+    float entropyDraw = 0.0f;
 
     //the reverb parameters
     juce::dsp::Reverb::Parameters reverbParameters;
-    juce::dsp::Reverb leftReverb, rightReverb;
 
-    //the chorus parameters
-    juce::dsp::Chorus<float> leftChorus, rightChorus;
+    //the reverbs and the choruses, nullptr until their stage is turned up, the audio thread asks for them and
+    //handleAsyncUpdate builds them for the rate prepareToPlay was last called with
+    //once a stage has been at 0 for engineReleaseSeconds the audio thread lets go of them and the timer frees them
+    RealtimeHandoff<ReverbEngines> reverbEngines;
+    RealtimeHandoff<ChorusEngines> chorusEngines;
+    std::atomic<bool> reverbRequested{ false }, chorusRequested{ false };
+    std::atomic<bool> reverbsReleased{ false }, chorusesReleased{ false };
+    std::atomic<size_t> reverbBytes{ 0 }, chorusBytes{ 0 };
+    juce::int64 reverbIdleSamples = 0, chorusIdleSamples = 0;
+    static constexpr double engineReleaseSeconds = 10.0;
+
+    //everything else prepareToPlay allocates for the chain, worked out there
+    std::atomic<size_t> preparedBytes{ 0 };
+
+    //the engines the reverb stage last saw, new ones fade in from the dry level on its own instead of jumping to
+    //the default parameters juce's reverb starts on
+    ReverbEngines* arrivedReverbs = nullptr;
+    juce::SmoothedValue<float> reverbArrival;
+
+    //the message thread builds under this, prepareToPlay might not be called on it
+    juce::CriticalSection engineLock;
+    double engineSampleRate = 44100.0;
+    int engineBlockSize     = 32;
+
+    //audio thread, asks for a stage's engines, only triggers the update the first time
+    void requestEngines(std::atomic<bool>& requested) noexcept;
+
+    //message thread, builds whatever was asked for and frees what the audio thread stopped using
+    void handleAsyncUpdate() override;
+    void buildEngines(bool buildReverb, bool buildChorus);
+
+    //message thread, under engineLock, frees what the audio thread stopped using and forgets engines it let go of
+    void collectEngines();
+
+    //only while the audio thread isn't running, frees every engine
+    void clearEngines();
+
+    //the other reverb engine, picked with Reverb Mode
+    ConvolutionReverb convolutionReverb;
+    std::atomic<float>* reverbMode = nullptr;
+
+    //whether the shared worker threads get used at all
+    std::atomic<float>* parallelDsp = nullptr;
+
+    //where the impulse response file's path lives in the plugin state
+    const juce::Identifier impulseResponseProperty = "ImpulseResponse";
+
+    //set from the state on load, a session saved before the distortion shapes stopped falling through keeps them that way
+    std::atomic<bool> chainedShapes{ false };
+
+    //Reduced Rate, the reverb and the chorus at a half or a quarter of a 96 or 192 kHz host rate, the engines have
+    //separate instances prepared at the low rate, the juce reverb allocates when its rate changes
+    RateReducer reverbReducer, chorusReducer;
+    int reducedFactor = 1;
+    std::atomic<float>* reducedRate = nullptr;
+
+    //the dry sides of the reduced stages, a whole number of samples late to line up with the way back up
+    IntegerDelay reverbDryDelay{ 128 }, chorusDryDelay{ 128 };
+    float reducedDryLevel = 1.0f;
+
+    //whether the reduced stages ran last block, their filters get cleared when they come back on
+    bool reverbWasReduced = false, chorusWasReduced = false;
 
     //functions used to create layouts that are passed back to the editor and attched to sliders
     juce::AudioProcessorValueTreeState::ParameterLayout createParameters();
 
-    //virtual function needed to be overriden
-    void parameterChanged(const juce::String& parameterID, float newValue) override {};
+    //temporary buffers for the stages, and the biggest chunk processChunk ever gets
+    ScratchArena scratch;
+    int preparedBlockSize = 512;
+
+    //the control grid, parameters, envelopes and filter coefficients are updated every this many samples
+    static const int controlBlockSize = 32;
+
+    //one per channel of the drive stage
+    std::vector<CrushState> crushStates;
+
+    //how many channels x block size views the stages can ask for in one chunk at most:
+    //distortion dry, crush dry, the 4x oversampled second morph shape, the convolution or reduced reverb's dry and
+    //the reduced chorus's dry, on a tier change the old way's output, its dry and its own second morph shape, and
+    //the reverb's dry level while new engines fade in
+    static const int scratchViewsPerBlock = 15;
+
+    //processBlock cuts the host's buffer up into control blocks and hands them here one by one, with where in the
+    //song the chunk starts
+    void processChunk(juce::AudioBuffer<float>& buffer, juce::AudioBuffer<float>& sidechainBuffer, double quarterNotes);
+
+    //Modulation Sync, the host's tempo and position, asked for once at the top of processBlock, every chunk works out
+    //its own position from them so nothing depends on how the host cuts up its buffers
+    struct Transport
+    {
+        bool synced = false;                //on, and the host gave a tempo
+        double quarterNotes = 0.0;          //at the start of the block
+        double quarterNotesPerSample = 0.0;
+
+        //the host's loop while it's playing one, a block that runs over the end carries on from the start
+        bool looping = false;
+        double loopStart = 0.0, loopEnd = 0.0;
+
+        //where sample of the block is in the song, wrapped back into the loop if the block went round it
+        double getPosition(int sample) const noexcept
+        {
+            auto position = quarterNotes + sample * quarterNotesPerSample;
+
+            if (looping && quarterNotes < loopEnd && position >= loopEnd)
+                position = loopStart + std::fmod(position - loopStart, loopEnd - loopStart);
+
+            return position;
+        }
+    };
+
+    Transport transport;
+
+    //where the modulation is up to, the host's own position while it plays, carried on at its tempo while it's
+    //stopped so the chorus doesn't freeze
+    double modulationQuarterNotes = 0.0;
+
+    std::atomic<float>* modulationSync  = nullptr;
+    std::atomic<float>* syncDivision    = nullptr;
+    std::atomic<float>* crushGate       = nullptr;
+
+    //Crush Gate, the crusher only comes in for the first half of every step, eased in and out so it doesn't click
+    juce::SmoothedValue<float> crushGateLevel;
+    bool crushGateOpen = true;
+
+    //reads the play head for the coming block
+    void updateTransport(int numSamples);
+
+    //how long a step of Sync Division is
+    double getSyncDivisionInQuarterNotes() const noexcept;
+
+    //virtual function needed to be overriden, also where the chain order gets swapped
+    void parameterChanged(const juce::String& parameterID, float newValue) override;
+
+    //what the stages need to know about the block being processed, worked out once at the top of processBlock
+    struct BlockState
+    {
+        ParameterSnapshot params;
+        float drive             = 1.0f;         //distortion gain plus the entropy offset
+        int morphChoices[2]     = { 0, 0 };     //distortion types of the A and B snapshots
+        bool crossfadeShapes    = false;
+        float morphAmount       = 0.0f;
+
+        float distortionMix     = 1.0f;
+        float crushMix          = 1.0f;
+        Dither dither           = Dither::none;
+        int oversampling        = 0;            //0 is off, 1 is 2x, 2 is 4x
+        ShapingFunctions::Quality shaperQuality = ShapingFunctions::Quality::polynomial;
+        Distortion::AntiAliasing antiAliasing   = Distortion::AntiAliasing::off;
+
+        //the oversampling and shaper quality being faded out, -1 while there's no fade
+        //the new way is held out for fadeHold samples and then comes in over a control block, fadePosition is
+        //how far into that this chunk starts
+        int fadeFromOversampling                = -1;
+        ShapingFunctions::Quality fadeFromShaperQuality = ShapingFunctions::Quality::polynomial;
+        int fadeHold                            = 0;
+        int fadePosition                        = 0;
+        const TransferTable* customCurve        = nullptr;
+        bool chainedShapes                      = false;
+        ReverbEngines* reverbs                  = nullptr;  //nullptr while the stage is off and never got built
+        ChorusEngines* choruses                 = nullptr;
+
+        StereoRouting chorusRouting = StereoRouting::stereo;
+        StereoRouting driveRouting  = StereoRouting::stereo;
+        StereoRouting reverbRouting = StereoRouting::stereo;
+
+        bool convolution        = false;        //Reverb Mode
+        bool parallel           = true;         //Parallel DSP
+        bool reducedReverb      = false;        //Reduced Rate, and only while it actually lowers the rate
+        bool reducedChorus      = false;
+    };
+
+    void processChorusStage(juce::AudioBuffer<float>& buffer, const BlockState& state);
+    void processDriveStage(juce::AudioBuffer<float>& buffer, const BlockState& state);
+    void processReverbStage(juce::AudioBuffer<float>& buffer, const BlockState& state);
+    void processFilterStage(juce::AudioBuffer<float>& buffer, const BlockState& state);
+
+    //the algorithmic reverb at the reduced rate, reverbParameters have to be set for the block
+    void processReducedReverb(juce::AudioBuffer<float>& buffer, ReverbEngines& reverbs);
+
+    //the distortion shapes on their own, at whatever rate the block is at, with the anti-aliasing states of the
+    //way they're being run
+    void processDistortionShapes(juce::dsp::AudioBlock<float>& block, const BlockState& state,
+                                 std::vector<Distortion::AntiAliasState>& shapeStates);
+
+    //the drive stage up to the crusher, the pre gain, the oversampled shapes and the blend with dry, which has to be
+    //lined up with the shapes already
+    void processDriveShapes(juce::AudioBuffer<float>& buffer, const juce::AudioBuffer<float>& dryBuffer,
+                            const BlockState& state, std::vector<Distortion::AntiAliasState>& shapeStates);
+
+    //how late the drive stage's shapes come out, the oversampling filters plus the anti-aliased shapes
+    float getDriveDelay(const BlockState& state) const noexcept;
+
+    //every chain order is its own instantiation, so the stages inside it are plain inlined calls
+    template <Stage stage>
+    void processStage(juce::AudioBuffer<float>& buffer, const BlockState& state);
+
+    template <Stage... stages>
+    void processChain(juce::AudioBuffer<float>& buffer, const BlockState& state);
+
+    using ChainFunction = void (RealMagiVerbAudioProcessor::*)(juce::AudioBuffer<float>&, const BlockState&);
+    static const ChainFunction chainOrders[numChainOrders];
+
+    //index into chainOrders, written from parameterChanged and read once per block
+    std::atomic<int> activeChainOrder{ 0 };
+
+    //true while the first two channels of the buffer hold mid and side instead of left and right
+    bool midSideDomain = false;
+    void setMidSideDomain(juce::AudioBuffer<float>& buffer, bool shouldBeMidSide);
+
+    //distortion oversampling, 2x and 4x
+    std::unique_ptr<juce::dsp::Oversampling<float>> oversamplers[2];
+
+    //the dry side of the parallel distortion, delayed to line up with the oversampled wet
+    juce::dsp::DelayLine<float, juce::dsp::DelayLineInterpolationTypes::Lagrange3rd> dryDelay{ 512 };
+
+    std::atomic<float>* distortionMix       = nullptr;
+    std::atomic<float>* crushMix            = nullptr;
+    std::atomic<float>* ditherMode          = nullptr;
+    std::atomic<float>* oversamplingChoice  = nullptr;
+    std::atomic<float>* shaperQuality       = nullptr;
+    std::atomic<float>* antiAliasing        = nullptr;
+
+    //two per channel, one for each of the morph shapes, the fade ones belong to the way a fade is leaving
+    std::vector<Distortion::AntiAliasState> antiAliasStates, fadeAntiAliasStates;
+
+    //whether the dry delay was pushed last chunk, if it wasn't it holds samples from whenever it last ran
+    bool dryDelayRunning = false;
+
+    //tells the host how much the oversampling, the reduced rate stages and the limiter delay the output,
+    //message thread, parameterChanged can be called on the audio thread so it only asks for it
+    void updateLatency();
+    std::atomic<bool> latencyChanged{ false };
+
+    //Quality Mode, on Auto it follows isNonRealtime(), the tier and the oversampling the audio thread is using
+    //change at the start of a chunk, whether it's the tier or the Oversampling knob that moved, and a change of
+    //oversampling has the drive stage crossfade from the old one over the next few chunks
+    std::atomic<float>* qualityMode = nullptr;
+    QualityTier activeQualityTier = QualityTier::asSet;
+    int activeOversampling = 0;
+
+    //the oversampling being faded out, -1 while there's no fade, and how far the fade has got
+    int driveFadeFrom = -1;
+    ShapingFunctions::Quality driveFadeFromQuality = ShapingFunctions::Quality::polynomial;
+    int driveFadeHold = 0;
+    int driveFadePosition = 0;
+
+    //audio thread, starts a fade from the oversampling the drive stage was running to the one in incoming
+    void startDriveFade(int fromOversampling, ShapingFunctions::Quality fromShaperQuality, const BlockState& incoming);
+
+    QualityTier getQualityTier() const noexcept;
+
+    //the drive stage's oversampling once the tier is applied, 0 is off, 1 is 2x, 2 is 4x
+    int getOversamplingIndex(QualityTier tier) const noexcept;
+
+    //Shaper Quality once the tier is applied
+    ShapingFunctions::Quality getShaperQuality(QualityTier tier) const noexcept;
+
+    //everything the drive stage keeps between blocks, a fade that was running is dropped
+    void resetDriveState();
+
+    //whether Reduced Rate takes the reverb or the chorus down, either can be asked for without lowering anything
+    bool isReverbReduced() const;
+    bool isChorusReduced() const;
+
+    std::atomic<float>* chorusRouting   = nullptr;
+    std::atomic<float>* chorusVoices    = nullptr;
+    std::atomic<float>* chorusInterpolation = nullptr;
+    std::atomic<float>* chorusFeedback  = nullptr;
+    std::atomic<float>* chorusDelay     = nullptr;
+    std::atomic<float>* driveRouting    = nullptr;
+    std::atomic<float>* reverbRouting   = nullptr;
 	
 	//independant high order filters
 	BetterFilter lowCutFilter;
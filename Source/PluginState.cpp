@@ -0,0 +1,179 @@
+#include "PluginState.h"
+
+namespace PluginState
+{
+    //every parameter of the processor, in the order they were added to the layout
+    static juce::Array<juce::RangedAudioParameter*> getRangedParameters(juce::AudioProcessor& processor)
+    {
+        juce::Array<juce::RangedAudioParameter*> params;
+
+        for (auto* param : processor.getParameters())
+            if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(param))
+                params.add(ranged);
+
+        return params;
+    }
+
+    juce::uint32 getLayoutHash(juce::AudioProcessor& processor)
+    {
+        juce::StringArray ids;
+
+        for (auto* param : getRangedParameters(processor))
+            ids.add(param->paramID);
+
+        return (juce::uint32) ids.joinIntoString("\n").hashCode();
+    }
+
+    //values coming from the outside world are never trusted, convertTo0to1 takes care of the range
+    //a session load isn't the user moving a knob, so the host gets no automation from it, only the apvts
+    //and the editor hear about the new value
+    static void setRawValue(juce::RangedAudioParameter& param, float value)
+    {
+        if (std::isfinite(value))
+        {
+            auto normalised = param.convertTo0to1(value);
+            param.setValue(normalised);
+            param.sendValueChangedMessageToListeners(normalised);
+        }
+    }
+
+    juce::ValueTree getExtraState(juce::AudioProcessorValueTreeState& apvts)
+    {
+        return apvts.state.getOrCreateChildWithName(extraStateType, nullptr);
+    }
+
+    //swaps the non-parameter child of the state for the one that was loaded, a blob without one clears it so
+    //nothing from the session before carries over
+    static void setExtraState(juce::AudioProcessorValueTreeState& apvts, const juce::ValueTree& extra)
+    {
+        auto existing = apvts.state.getChildWithName(extraStateType);
+
+        if (existing.isValid())
+            apvts.state.removeChild(existing, nullptr);
+
+        if (extra.isValid())
+            apvts.state.appendChild(extra, nullptr);
+    }
+
+    //the format every session before the binary one was saved in
+    static bool readLegacyXml(juce::AudioProcessorValueTreeState& apvts, const void* data, int sizeInBytes)
+    {
+        std::unique_ptr<juce::XmlElement> xml = juce::AudioProcessor::getXmlFromBinary(data, sizeInBytes);
+
+        if (xml == nullptr || ! xml->hasTagName(apvts.state.getType().toString()))
+            return false;
+
+        apvts.replaceState(juce::ValueTree::fromXml(*xml));
+        getExtraState(apvts).setProperty(chainedShapesProperty, true, nullptr);
+        return true;
+    }
+
+    void write(juce::AudioProcessorValueTreeState& apvts, juce::MemoryBlock& destData)
+    {
+        auto params = getRangedParameters(apvts.processor);
+
+        juce::MemoryOutputStream stream(destData, false);
+
+        stream.writeInt((int) magic);
+        stream.writeInt((int) version);
+        stream.writeInt((int) getLayoutHash(apvts.processor));
+        stream.writeInt(params.size());
+
+        for (auto* param : params)
+            stream.writeFloat(param->convertFrom0to1(param->getValue()));
+
+        juce::MemoryOutputStream ids;
+
+        for (auto* param : params)
+            ids.writeString(param->paramID);
+
+        stream.writeInt((int) ids.getDataSize());
+        stream.write(ids.getData(), ids.getDataSize());
+
+        juce::MemoryOutputStream extra;
+        auto extraState = apvts.copyState().getChildWithName(extraStateType);
+
+        if (extraState.isValid())
+            extraState.writeToStream(extra);
+
+        stream.writeInt((int) extra.getDataSize());
+        stream.write(extra.getData(), extra.getDataSize());
+    }
+
+    bool read(juce::AudioProcessorValueTreeState& apvts, const void* data, int sizeInBytes)
+    {
+        if (data == nullptr || sizeInBytes < 4)
+            return false;
+
+        juce::MemoryInputStream stream(data, (size_t) sizeInBytes, false);
+
+        if ((juce::uint32) stream.readInt() != magic)
+            return readLegacyXml(apvts, data, sizeInBytes);
+
+        //everything gets validated before a single parameter is touched
+        if (stream.getNumBytesRemaining() < 12)
+            return false;
+
+        auto dataVersion    = (juce::uint32) stream.readInt();
+        auto layoutHash     = (juce::uint32) stream.readInt();
+        auto numValues      = stream.readInt();
+
+        if (dataVersion == 0 || dataVersion > version)
+            return false;
+
+        if (numValues < 0 || (juce::int64) numValues * 4 + 8 > stream.getNumBytesRemaining())
+            return false;
+
+        std::vector<float> values((size_t) numValues);
+
+        for (auto& value : values)
+            value = stream.readFloat();
+
+        auto idTableSize = stream.readInt();
+
+        if (idTableSize < 0 || (juce::int64) idTableSize + 4 > stream.getNumBytesRemaining())
+            return false;
+
+        juce::MemoryBlock idTable;
+        stream.readIntoMemoryBlock(idTable, idTableSize);
+
+        auto extraSize = stream.readInt();
+
+        if (extraSize < 0 || (juce::int64) extraSize > stream.getNumBytesRemaining())
+            return false;
+
+        juce::ValueTree extra;
+
+        if (extraSize > 0)
+        {
+            extra = juce::ValueTree::readFromData(static_cast<const char*>(data) + stream.getPosition(), (size_t) extraSize);
+
+            if (! extra.hasType(extraStateType))
+                return false;
+        }
+
+        auto params = getRangedParameters(apvts.processor);
+
+        //fast path, same plugin layout so the values line up one to one
+        if (layoutHash == getLayoutHash(apvts.processor) && numValues == params.size())
+        {
+            for (int i = 0; i < numValues; ++i)
+                setRawValue(*params[i], values[(size_t) i]);
+        }
+        else
+        {
+            juce::MemoryInputStream ids(idTable, false);
+
+            for (int i = 0; i < numValues && ! ids.isExhausted(); ++i)
+                if (auto* param = apvts.getParameter(ids.readString()))
+                    setRawValue(*param, values[(size_t) i]);
+        }
+
+        setExtraState(apvts, extra);
+
+        if (dataVersion < 2)
+            getExtraState(apvts).setProperty(chainedShapesProperty, true, nullptr);
+
+        return true;
+    }
+}
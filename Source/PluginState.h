@@ -0,0 +1,42 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+/*the binary layout of the plugin state, every number is written little endian
+
+    uint32  magic           "MGFX"
+    uint32  version
+    uint32  layout hash     hash of every parameter id in layout order
+    uint32  parameter count
+    float   values[count]   raw (denormalised) parameter values in layout order
+    uint32  id table size   followed by the parameter ids as null terminated utf8 strings
+    uint32  extra size      followed by a binary ValueTree holding everything that isn't a parameter
+
+when the layout hash matches the running plugin the values are applied straight in order,
+otherwise they are matched up with the id table so older sessions still load
+
+before version 2 every distortion shape ran on into the ones after it in the list, sessions from then (and the xml
+ones) get chainedShapesProperty set in their extra state when they're read so they keep sounding the way they were
+saved, it's saved along with the rest of the extra state from then on*/
+namespace PluginState
+{
+    const juce::uint32 magic    = 0x5846474d;
+    const juce::uint32 version  = 2;
+
+    //name of the child tree in apvts.state that holds all the non-parameter state
+    const juce::Identifier extraStateType = "Extra";
+    const juce::Identifier chainedShapesProperty = "ChainedShapes";
+
+    //the child of apvts.state that holds the non-parameter state, created if it isn't there yet
+    juce::ValueTree getExtraState(juce::AudioProcessorValueTreeState& apvts);
+
+    //writes the whole state of the value tree state into the memory block
+    void write(juce::AudioProcessorValueTreeState& apvts, juce::MemoryBlock& destData);
+
+    //reads either the binary format or the old xml blobs, returns false if the data was unusable
+    //in which case the current state is left untouched
+    bool read(juce::AudioProcessorValueTreeState& apvts, const void* data, int sizeInBytes);
+
+    //hash of all the parameter ids in the order the processor exposes them
+    juce::uint32 getLayoutHash(juce::AudioProcessor& processor);
+}
@@ -0,0 +1,328 @@
+#include "PresetBank.h"
+
+//reads a little endian float out of the mapped file, the records aren't guaranteed to be aligned
+static float readFloat(const char* data)
+{
+    auto bits = juce::ByteOrder::littleEndianInt(data);
+    float value;
+    std::memcpy(&value, &bits, sizeof(float));
+    return value;
+}
+
+//every generation is this name with its number after it, the first one has none
+static const char* const bankName       = "MagiFect";
+static const char* const bankExtension  = ".mgpb";
+
+PresetBank::PresetBank()
+{
+}
+
+PresetBank::~PresetBank()
+{
+    if (notifier != nullptr)
+        (*notifier)->removeChangeListener(this);
+
+    close();
+}
+
+void PresetBank::setLayout(const juce::StringArray& parameterIDs)
+{
+    layoutIDs = parameterIDs;
+    matchColumns();
+}
+
+bool PresetBank::open(const juce::File& folder)
+{
+    bankFolder = folder;
+
+    if (notifier == nullptr)
+    {
+        notifier = std::make_unique<juce::SharedResourcePointer<Notifier>>();
+        (*notifier)->addChangeListener(this);
+    }
+
+    return map(findNewest());
+}
+
+int PresetBank::getGeneration(const juce::File& file)
+{
+    auto name = file.getFileNameWithoutExtension();
+
+    if (! file.hasFileExtension(bankExtension) || ! name.startsWith(bankName))
+        return -1;
+
+    auto number = name.substring(juce::String(bankName).length()).trim();
+
+    if (number.isEmpty())
+        return 0;
+
+    return number.containsOnly("0123456789") ? number.getIntValue() : -1;
+}
+
+juce::File PresetBank::findNewest() const
+{
+    juce::File newest;
+
+    for (auto& file : bankFolder.findChildFiles(juce::File::findFiles, false, juce::String(bankName) + "*" + bankExtension))
+        if (getGeneration(file) > getGeneration(newest))
+            newest = file;
+
+    return newest;
+}
+
+void PresetBank::changeListenerCallback(juce::ChangeBroadcaster*)
+{
+    auto newest = findNewest();
+
+    if (newest != juce::File() && newest != bankFile)
+    {
+        map(newest);
+
+        if (onChange != nullptr)
+            onChange();
+    }
+
+    //the last bank to switch over is the one that gets to delete the old generations, on windows a delete fails
+    //while any instance, in this process or another, still has the file mapped, a later switch tries again
+    for (auto& file : bankFolder.findChildFiles(juce::File::findFiles, false, juce::String(bankName) + "*" + bankExtension))
+        if (juce::isPositiveAndBelow(getGeneration(file), getGeneration(bankFile)))
+            file.deleteFile();
+}
+
+bool PresetBank::map(const juce::File& file)
+{
+    close();
+    bankFile = file;
+
+    if (! file.existsAsFile())
+        return false;
+
+    auto mapped = std::make_unique<juce::MemoryMappedFile>(file, juce::MemoryMappedFile::readOnly);
+    auto* data  = static_cast<const char*>(mapped->getData());
+    auto size   = (juce::uint64) mapped->getSize();
+
+    if (data == nullptr || size < (juce::uint64) headerSize)
+        return false;
+
+    auto fileMagic      = juce::ByteOrder::littleEndianInt(data);
+    auto fileVersion    = juce::ByteOrder::littleEndianInt(data + 4);
+    auto fileParams     = (int) juce::ByteOrder::littleEndianInt(data + 8);
+    auto filePresets    = (int) juce::ByteOrder::littleEndianInt(data + 12);
+
+    if (fileMagic != magic || fileVersion == 0 || fileVersion > version)
+        return false;
+
+    if (fileParams <= 0 || fileParams > 1024 || filePresets < 0)
+        return false;
+
+    auto tableSize  = (juce::uint64) fileParams * idSize;
+    auto recSize    = (juce::uint64) nameSize + (juce::uint64) fileParams * sizeof(float);
+
+    if (size < (juce::uint64) headerSize + tableSize + (juce::uint64) filePresets * recSize)
+        return false;
+
+    //the id table is the only thing that gets parsed, once, the records are just offsets after this
+    columnIDs.clearQuick();
+
+    for (int column = 0; column < fileParams; ++column)
+    {
+        auto* id = data + headerSize + (size_t) column * idSize;
+        columnIDs.add(juce::String::fromUTF8(id, (int) strnlen(id, idSize)));
+    }
+
+    mappedFile      = std::move(mapped);
+    records         = data + headerSize + tableSize;
+    numPresets      = filePresets;
+    numFileParams   = fileParams;
+    recordSize      = (size_t) recSize;
+
+    matchColumns();
+    return true;
+}
+
+void PresetBank::matchColumns()
+{
+    columnParameters.clear();
+
+    for (auto& id : columnIDs)
+        columnParameters.push_back(id.isNotEmpty() ? layoutIDs.indexOf(id) : -1);
+}
+
+void PresetBank::close()
+{
+    mappedFile.reset();
+    records         = nullptr;
+    numPresets      = 0;
+    numFileParams   = 0;
+    recordSize      = 0;
+    columnIDs.clear();
+    columnParameters.clear();
+}
+
+juce::String PresetBank::getPresetName(int index) const
+{
+    if (! juce::isPositiveAndBelow(index, numPresets))
+        return {};
+
+    auto* name = records + (size_t) index * recordSize;
+    return juce::String::fromUTF8(name, (int) strnlen(name, nameSize));
+}
+
+bool PresetBank::getPreset(int index, std::vector<float>& values) const
+{
+    if (! juce::isPositiveAndBelow(index, numPresets))
+        return false;
+
+    values.assign((size_t) layoutIDs.size(), std::numeric_limits<float>::quiet_NaN());
+
+    //the columns were matched to the layout when the bank was mapped, a recall is just the offsets
+    auto* record = records + (size_t) index * recordSize + nameSize;
+
+    for (int column = 0; column < numFileParams; ++column)
+    {
+        auto parameter = columnParameters[(size_t) column];
+
+        if (parameter >= 0)
+            values[(size_t) parameter] = readFloat(record + (size_t) column * sizeof(float));
+    }
+
+    return true;
+}
+
+void PresetBank::readPreset(int index, juce::NamedValueSet& values) const
+{
+    auto* record = records + (size_t) index * recordSize + nameSize;
+
+    for (int column = 0; column < numFileParams; ++column)
+    {
+        auto value = readFloat(record + (size_t) column * sizeof(float));
+
+        if (columnIDs[column].isNotEmpty() && std::isfinite(value))
+            values.set(columnIDs[column], value);
+    }
+}
+
+void PresetBank::readAll(juce::StringArray& names, juce::Array<juce::NamedValueSet>& presets) const
+{
+    for (int index = 0; index < numPresets; ++index)
+    {
+        juce::NamedValueSet values;
+        readPreset(index, values);
+
+        names.add(getPresetName(index));
+        presets.add(values);
+    }
+}
+
+bool PresetBank::replace(const juce::StringArray& names, const juce::Array<juce::NamedValueSet>& presets)
+{
+    //nobody has the next generation mapped, so it can be written on every platform, the one in use stays as it is
+    auto generation = juce::jmax(getGeneration(findNewest()), getGeneration(bankFile)) + 1;
+    auto file = bankFolder.getChildFile(juce::String(bankName) + (generation > 0 ? " " + juce::String(generation) : juce::String()) + bankExtension);
+
+    if (! write(file, names, presets))
+        return false;
+
+    map(file);
+    (*notifier)->sendChangeMessage();
+    return true;
+}
+
+bool PresetBank::addPreset(const juce::String& name, const juce::NamedValueSet& values)
+{
+    if (bankFolder == juce::File() || notifier == nullptr)
+        return false;
+
+    //another process could have written a generation this one hasn't heard about, the preset goes on the end of that
+    auto newest = findNewest();
+
+    if (newest != bankFile)
+        map(newest);
+
+    juce::StringArray names;
+    juce::Array<juce::NamedValueSet> presets;
+    readAll(names, presets);
+
+    names.add(name);
+    presets.add(values);
+
+    return replace(names, presets);
+}
+
+bool PresetBank::renamePreset(int index, const juce::String& name)
+{
+    if (! juce::isPositiveAndBelow(index, numPresets))
+        return false;
+
+    juce::StringArray names;
+    juce::Array<juce::NamedValueSet> presets;
+    readAll(names, presets);
+
+    names.set(index, name);
+
+    return replace(names, presets);
+}
+
+bool PresetBank::write(const juce::File& file, const juce::StringArray& names, const juce::Array<juce::NamedValueSet>& presets)
+{
+    jassert(names.size() == presets.size());
+
+    //every parameter any preset has gets a column, in the order they first turn up
+    juce::StringArray ids;
+
+    for (auto& preset : presets)
+        for (auto& value : preset)
+            ids.addIfNotAlreadyThere(value.name.toString());
+
+    if (ids.isEmpty())
+        ids.add({});
+
+    juce::MemoryOutputStream stream;
+
+    //writes a string null padded to a fixed size, chopping characters off until it fits
+    auto writeFixed = [&stream](juce::String text, int size)
+    {
+        while ((int) text.getNumBytesAsUTF8() > size - 1)
+            text = text.dropLastCharacters(1);
+
+        juce::HeapBlock<char> field((size_t) size, true);
+        text.copyToUTF8(field.get(), (size_t) size);
+        stream.write(field.get(), (size_t) size);
+    };
+
+    stream.writeInt((int) magic);
+    stream.writeInt((int) version);
+    stream.writeInt(ids.size());
+    stream.writeInt(presets.size());
+
+    for (auto& id : ids)
+        writeFixed(id, idSize);
+
+    for (int preset = 0; preset < presets.size(); ++preset)
+    {
+        writeFixed(names[preset], nameSize);
+
+        //a parameter this preset doesn't have is left alone when it's recalled
+        auto& values = presets.getReference(preset);
+
+        for (auto& id : ids)
+        {
+            auto* value = values.getVarPointer(id);
+            stream.writeFloat(value != nullptr ? (float) *value : std::numeric_limits<float>::quiet_NaN());
+        }
+    }
+
+    //written next to it and moved into place, so a bank that gets mapped is never half written
+    file.getParentDirectory().createDirectory();
+    juce::TemporaryFile temporary(file);
+
+    return temporary.getFile().replaceWithData(stream.getData(), stream.getDataSize())
+        && temporary.overwriteTargetFileWithTemporary();
+}
+
+juce::File PresetBank::getDefaultFolder()
+{
+    return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+        .getChildFile("alfy")
+        .getChildFile("MagiFect");
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+/*a bank of presets stored in one file that gets memory mapped instead of parsed
+
+    uint32  magic               "MGPB"
+    uint32  version
+    uint32  parameter count     P
+    uint32  preset count        N
+    char    ids[P][32]          parameter ids, null padded
+    N records of
+        char    name[32]        preset name, null padded utf8
+        float   values[P]       raw parameter values
+
+every record is the same size, so finding preset i is just an offset, opening a bank with
+thousands of presets only reads the header and the id table
+
+a preset holds every parameter of the layout it was saved from, one that isn't finite is a parameter that preset
+doesn't have, it keeps whatever value it had when the preset is recalled
+
+a bank that's mapped can't be written over on windows, so a bank is never changed in place, every change writes the
+next generation next to it, "MagiFect 12.mgpb" after "MagiFect 11.mgpb", and every bank in the process switches over
+to it through a shared notifier, the old generations get deleted once nothing has them mapped any more*/
+class PresetBank : private juce::ChangeListener
+{
+public:
+    PresetBank();
+    ~PresetBank() override;
+
+    //message thread, the ids of the parameters presets get recalled into, in the order getPreset gives their values,
+    //every column of a bank is matched to one of these once, when it's mapped
+    void setLayout(const juce::StringArray& parameterIDs);
+
+    //maps the newest bank in the folder and follows the ones written after it, false (and an empty bank) if there's
+    //none yet or it's malformed, the first preset saved creates one
+    bool open(const juce::File& folder);
+    void close();
+
+    int getNumPresets() const noexcept { return numPresets; }
+    juce::String getPresetName(int index) const;
+
+    //the raw values of preset "index" in layout order, NaN for the parameters the preset doesn't have
+    bool getPreset(int index, std::vector<float>& values) const;
+
+    //message thread, these write the next generation of the bank and map that, the bank is created if there wasn't one
+    bool addPreset(const juce::String& name, const juce::NamedValueSet& values);
+    bool renamePreset(int index, const juce::String& name);
+
+    //message thread, called once this bank switched to a generation another instance wrote
+    std::function<void()> onChange;
+
+    //writes a whole bank in one go, the columns are every parameter id any of the presets has
+    static bool write(const juce::File& file, const juce::StringArray& names, const juce::Array<juce::NamedValueSet>& presets);
+
+    //where the banks that show up in the host's program list live
+    static juce::File getDefaultFolder();
+
+    static const juce::uint32 magic     = 0x4250474d;
+    static const juce::uint32 version   = 1;
+    static const int nameSize           = 32;
+    static const int idSize             = 32;
+    static const int headerSize         = 16;
+
+private:
+    //every bank of the process listens, whoever writes a new generation tells the others
+    struct Notifier : public juce::ChangeBroadcaster {};
+    std::unique_ptr<juce::SharedResourcePointer<Notifier>> notifier;
+
+    //what open was last called with, and the generation mapped from it, if there was one
+    juce::File bankFolder;
+    juce::File bankFile;
+    std::unique_ptr<juce::MemoryMappedFile> mappedFile;
+
+    const char* records = nullptr;
+    int numPresets      = 0;
+    int numFileParams   = 0;
+    size_t recordSize   = 0;
+
+    //the parameter id of every column in the file, and where it goes in the layout, -1 if it isn't in it
+    juce::StringArray columnIDs;
+    std::vector<int> columnParameters;
+    juce::StringArray layoutIDs;
+
+    //maps one generation, the table from columns to the layout gets built here
+    bool map(const juce::File& file);
+    void matchColumns();
+
+    //the raw values of preset "index" by parameter id, only the ones the preset has
+    void readPreset(int index, juce::NamedValueSet& values) const;
+
+    //every preset in the bank, read out so the next generation can be written
+    void readAll(juce::StringArray& names, juce::Array<juce::NamedValueSet>& presets) const;
+
+    //writes the next generation, maps it and tells every other bank
+    bool replace(const juce::StringArray& names, const juce::Array<juce::NamedValueSet>& presets);
+
+    //the generation in a bank file's name, 0 for the one without a number, -1 for anything that isn't a bank
+    static int getGeneration(const juce::File& file);
+    juce::File findNewest() const;
+
+    //another bank wrote a new generation
+    void changeListenerCallback(juce::ChangeBroadcaster*) override;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PresetBank)
+};
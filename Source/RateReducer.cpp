@@ -0,0 +1,276 @@
+#include "RateReducer.h"
+
+namespace
+{
+    //the zeroth order modified bessel function, for the kaiser window
+    double besselI0(double x)
+    {
+        double sum = 1.0, term = 1.0;
+
+        for (int k = 1; k < 32; ++k)
+        {
+            term *= (x / (2.0 * k)) * (x / (2.0 * k));
+            sum += term;
+        }
+
+        return sum;
+    }
+
+    //writes a sample into a mirrored history, the newest length samples then sit in [position, position + length)
+    inline void push(float* history, int& position, int length, float sample) noexcept
+    {
+        history[position] = sample;
+        history[position + length] = sample;
+
+        if (++position == length)
+            position = 0;
+    }
+
+    //the symmetric half of a half-band filter over a window of 2K + 2 samples, oldest first
+    inline float sidePairs(const float* window, const float* coefficients, int halfLength) noexcept
+    {
+        float sum = 0.0f;
+
+        for (int j = 0; j <= halfLength; ++j)
+            sum += coefficients[j] * (window[halfLength - j] + window[halfLength + 1 + j]);
+
+        return sum;
+    }
+}
+
+//==============================================================================
+void RateReducer::Stage::prepare(int newHalfLength, double attenuationDb, int numChannels)
+{
+    halfLength = newHalfLength;
+
+    //a kaiser windowed sinc cut off at a quarter of the rate, every other tap of that is zero except the centre one
+    auto beta = 0.1102 * (attenuationDb - 8.7);
+    auto centre = 2.0 * halfLength + 1.0;
+    double sum = 0.0;
+
+    coefficients.resize((size_t) halfLength + 1);
+
+    for (int j = 0; j <= halfLength; ++j)
+    {
+        auto offset = 2.0 * j + 1.0;
+        auto ratio = offset / centre;
+        auto window = besselI0(beta * std::sqrt(1.0 - ratio * ratio)) / besselI0(beta);
+        auto tap = (j % 2 == 0 ? 1.0 : -1.0) / (juce::MathConstants<double>::pi * offset) * window;
+
+        coefficients[(size_t) j] = (float) tap;
+        sum += tap;
+    }
+
+    //the side taps add up to a quarter on each side, with the 0.5 in the middle dc goes through untouched
+    for (auto& coefficient : coefficients)
+        coefficient = (float) (coefficient * 0.25 / sum);
+
+    auto sideLength = (size_t) (2 * halfLength + 2);
+
+    oddInputs.assign((size_t) numChannels, std::vector<float>(sideLength * 2, 0.0f));
+    evenInputs.assign((size_t) numChannels, std::vector<float>(((size_t) halfLength + 1) * 2, 0.0f));
+    lowInputs.assign((size_t) numChannels, std::vector<float>(sideLength * 2, 0.0f));
+    pending.assign((size_t) numChannels, 0.0f);
+
+    reset();
+}
+
+void RateReducer::Stage::reset()
+{
+    for (auto* histories : { &oddInputs, &evenInputs, &lowInputs })
+        for (auto& history : *histories)
+            std::fill(history.begin(), history.end(), 0.0f);
+
+    std::fill(pending.begin(), pending.end(), 0.0f);
+
+    oddPosition = evenPosition = lowPosition = 0;
+    downPhase = upPhase = false;
+}
+
+int RateReducer::Stage::down(const float* const* input, float* const* output, int channelsToDo, int numSamples) noexcept
+{
+    auto sideLength = 2 * halfLength + 2;
+    auto evenLength = halfLength + 1;
+    auto* taps = coefficients.data();
+    int written = 0;
+
+    //every channel starts from the same place, it's only stored back once they're all done
+    auto startPhase = downPhase;
+    auto startOdd = oddPosition, startEven = evenPosition;
+
+    for (int channel = 0; channel < channelsToDo; ++channel)
+    {
+        auto* odd = oddInputs[(size_t) channel].data();
+        auto* even = evenInputs[(size_t) channel].data();
+        auto phase = startPhase;
+        oddPosition = startOdd;
+        evenPosition = startEven;
+        written = 0;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            if (! phase)
+            {
+                push(even, evenPosition, evenLength, input[channel][i]);
+            }
+            else
+            {
+                push(odd, oddPosition, sideLength, input[channel][i]);
+
+                //the centre tap lands on the even sample K pairs back, the oldest in its history
+                output[channel][written++] = 0.5f * even[evenPosition] + sidePairs(odd + oddPosition, taps, halfLength);
+            }
+
+            phase = ! phase;
+        }
+
+        downPhase = phase;
+    }
+
+    return written;
+}
+
+void RateReducer::Stage::up(const float* const* input, float* const* output, int channelsToDo, int numSamples) noexcept
+{
+    auto sideLength = 2 * halfLength + 2;
+    auto* taps = coefficients.data();
+
+    auto startPhase = upPhase;
+    auto startLow = lowPosition;
+
+    for (int channel = 0; channel < channelsToDo; ++channel)
+    {
+        auto* low = lowInputs[(size_t) channel].data();
+        auto phase = startPhase;
+        auto held = pending[(size_t) channel];
+        lowPosition = startLow;
+        int read = 0;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            if (phase)
+            {
+                //a new low rate sample makes a pair, the filtered one goes out now and the one that's just the
+                //sample K back goes out next, the gain of 2 that zero stuffing needs is folded in
+                push(low, lowPosition, sideLength, input[channel][read++]);
+
+                auto* window = low + lowPosition;
+                output[channel][i] = 2.0f * sidePairs(window, taps, halfLength);
+                held = window[halfLength + 1];
+            }
+            else
+            {
+                output[channel][i] = held;
+            }
+
+            phase = ! phase;
+        }
+
+        pending[(size_t) channel] = held;
+        upPhase = phase;
+    }
+}
+
+//==============================================================================
+void RateReducer::prepare(int factor, int maxBlockSize, int newNumChannels)
+{
+    numChannels = newNumChannels;
+    stages.clear();
+
+    //the first stage of a 4x cascade only has to keep the audio band out of the band that folds down, which leaves
+    //it a wide transition and a short filter, the last one needs the long one
+    if (factor >= 4)
+        stages.emplace_back();
+
+    if (factor >= 2)
+        stages.emplace_back();
+
+    latency = 0;
+
+    for (size_t i = 0; i < stages.size(); ++i)
+    {
+        auto last = i + 1 == stages.size();
+        auto halfLength = last ? 10 : 4;
+        stages[i].prepare(halfLength, 70.0, numChannels);
+
+        //4K + 2 samples at the stage's rate
+        latency += (4 * halfLength + 2) << i;
+
+        buffers[i].setSize(numChannels, (maxBlockSize >> (i + 1)) + 1, false, true, false);
+    }
+}
+
+size_t RateReducer::getSizeInBytes() const noexcept
+{
+    size_t samples = 0;
+
+    for (auto& stage : stages)
+    {
+        samples += stage.coefficients.size() + stage.pending.size();
+
+        for (size_t channel = 0; channel < stage.oddInputs.size(); ++channel)
+            samples += stage.oddInputs[channel].size() + stage.evenInputs[channel].size() + stage.lowInputs[channel].size();
+    }
+
+    for (size_t i = 0; i < stages.size(); ++i)
+        samples += (size_t) buffers[i].getNumChannels() * (size_t) buffers[i].getNumSamples();
+
+    return samples * sizeof(float);
+}
+
+void RateReducer::reset()
+{
+    for (auto& stage : stages)
+        stage.reset();
+}
+
+juce::AudioBuffer<float> RateReducer::processDown(const juce::AudioBuffer<float>& buffer) noexcept
+{
+    if (stages.empty())
+    {
+        jassertfalse;
+        return {};
+    }
+
+    auto channelsToDo = juce::jmin(numChannels, buffer.getNumChannels());
+    auto numSamples = buffer.getNumSamples();
+    auto* input = buffer.getArrayOfReadPointers();
+
+    for (size_t i = 0; i < stages.size(); ++i)
+    {
+        counts[i] = stages[i].down(input, buffers[i].getArrayOfWritePointers(), channelsToDo, numSamples);
+        input = buffers[i].getArrayOfReadPointers();
+        numSamples = counts[i];
+    }
+
+    auto& last = buffers[stages.size() - 1];
+    return juce::AudioBuffer<float>(last.getArrayOfWritePointers(), channelsToDo, counts[stages.size() - 1]);
+}
+
+void RateReducer::processUp(juce::AudioBuffer<float>& buffer) noexcept
+{
+    if (stages.empty())
+        return;
+
+    auto channelsToDo = juce::jmin(numChannels, buffer.getNumChannels());
+
+    //back up from the lowest rate, each stage filling the buffer the one above it went down from
+    for (auto i = (int) stages.size() - 1; i >= 0; --i)
+    {
+        auto* output = i > 0 ? buffers[i - 1].getArrayOfWritePointers() : buffer.getArrayOfWritePointers();
+        auto numSamples = i > 0 ? counts[i - 1] : buffer.getNumSamples();
+
+        stages[(size_t) i].up(buffers[i].getArrayOfReadPointers(), output, channelsToDo, numSamples);
+    }
+}
+
+int RateReducer::getFactorForRate(double sampleRate) noexcept
+{
+    if (sampleRate > 100000.0)
+        return 4;
+
+    if (sampleRate > 50000.0)
+        return 2;
+
+    return 1;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+/*runs part of the chain at a half or a quarter of the host's rate
+
+the signal goes down through a cascade of half-band fir filters, gets processed at the lower rate and comes back up
+through the same cascade, the filters are polyphase so every one only works at the rate of its lower side and half
+its taps are zero anyway, and symmetric so the other half come in pairs
+
+a block of any length can go through, a stage takes its new low rate sample on the odd full rate samples and the
+count carries over between blocks, so down gives back exactly as many low rate samples as up needs to fill the
+block again, every channel has to go through both with the same block
+
+the way back up is exactly getLatencyInSamples() late at the full rate, a whole number, the dry side of whatever
+runs in between gets delayed by that*/
+class RateReducer
+{
+public:
+    RateReducer() = default;
+
+    //factor is 1, 2 or 4, message thread, at 1 there's nothing to do and the caller runs at the full rate
+    void prepare(int factor, int maxBlockSize, int numChannels);
+    void reset();
+
+    int getFactor() const noexcept                  { return 1 << (int) stages.size(); }
+    int getLatencyInSamples() const noexcept        { return latency; }
+
+    //the filter histories and the low rate buffers prepare allocated
+    size_t getSizeInBytes() const noexcept;
+
+    //audio thread, the first numChannels of the buffer down to the low rate, the view is into this object and stays
+    //valid until the next down, process it in place
+    juce::AudioBuffer<float> processDown(const juce::AudioBuffer<float>& buffer) noexcept;
+
+    //audio thread, what down gave back, back up into the buffer, replacing what's in it
+    void processUp(juce::AudioBuffer<float>& buffer) noexcept;
+
+    //the factor that brings a host rate down to 48 kHz or less
+    static int getFactorForRate(double sampleRate) noexcept;
+
+private:
+    //one 2x step of the cascade, every channel has its own history but they all share where the stage is in its
+    //pair of full rate samples
+    struct Stage
+    {
+        //the nonzero side taps, symmetric around the centre one which is always 0.5
+        std::vector<float> coefficients;
+        int halfLength = 0;     //K, the filter is 4K + 3 long
+
+        //per channel, mirrored so a window of the history never wraps
+        std::vector<std::vector<float>> oddInputs, evenInputs, lowInputs;
+        std::vector<float> pending;
+        int oddPosition = 0, evenPosition = 0, lowPosition = 0;
+        bool downPhase = false, upPhase = false;
+
+        void prepare(int newHalfLength, double attenuationDb, int numChannels);
+        void reset();
+
+        //every channel with the same numSamples, returns how many low rate samples it wrote
+        int down(const float* const* input, float* const* output, int numChannels, int numSamples) noexcept;
+
+        //fills numSamples full rate samples, taking as many low rate ones as down gave back for that many
+        void up(const float* const* input, float* const* output, int numChannels, int numSamples) noexcept;
+    };
+
+    std::vector<Stage> stages;
+
+    //what every stage gave back on the way down, the last one is what the caller gets to process and the way up
+    //goes back through the same buffers
+    juce::AudioBuffer<float> buffers[2];
+    int counts[2] = {};
+    int numChannels = 0;
+    int latency = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RateReducer)
+};
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+/*hands objects built on the message thread over to the audio thread without either side waiting
+
+the message thread builds a new object and calls set(), the audio thread picks it up with get() at the top of a block
+and from then on owns it, whatever it was using before goes into the retired slot and is deleted back on the message
+thread by collectGarbage(), so nothing is ever allocated or freed on the audio thread
+
+there's only one retired slot, the audio thread leaves a new object pending until the last retired one was collected*/
+template <typename ObjectType>
+class RealtimeHandoff
+{
+public:
+    RealtimeHandoff() = default;
+
+    ~RealtimeHandoff()
+    {
+        delete pending.exchange(nullptr);
+        delete retired.exchange(nullptr);
+        delete current;
+    }
+
+    //any thread but the audio one, replaces whatever was pending and not picked up yet
+    void set(std::unique_ptr<ObjectType> newObject)
+    {
+        delete pending.exchange(newObject.release());
+    }
+
+    //audio thread, the object to use for this block, can be nullptr if nothing was ever set
+    ObjectType* get() noexcept
+    {
+        if (retired.load() == nullptr && pending.load() != nullptr)
+        {
+            auto* previous = current;
+            current = pending.exchange(nullptr);
+            retired.store(previous);
+        }
+
+        return current;
+    }
+
+    //audio thread, true if the next get() will switch over to a new object
+    bool hasPending() const noexcept { return retired.load() == nullptr && pending.load() != nullptr; }
+
+    //audio thread, lets go of the object it's using so the next get() gives nullptr and collectGarbage() frees it,
+    //only while nothing is pending or still waiting to be collected, true if it did
+    bool release() noexcept
+    {
+        if (current == nullptr || pending.load() != nullptr || retired.load() != nullptr)
+            return false;
+
+        retired.store(current);
+        current = nullptr;
+        return true;
+    }
+
+    //message thread, frees whatever the audio thread stopped using, the owner decides when that's safe
+    void collectGarbage()
+    {
+        delete retired.exchange(nullptr);
+    }
+
+    //anything but the audio thread, only valid while the audio thread isn't running (prepareToPlay and the like)
+    ObjectType* getCurrentUnsafe() const noexcept { return current; }
+
+    //same goes for this one, deletes everything so get() gives nullptr until something new is set
+    void clearUnsafe()
+    {
+        delete pending.exchange(nullptr);
+        delete retired.exchange(nullptr);
+        delete current;
+        current = nullptr;
+    }
+
+private:
+    std::atomic<ObjectType*> pending{ nullptr };
+    std::atomic<ObjectType*> retired{ nullptr };
+    ObjectType* current = nullptr;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RealtimeHandoff)
+};
@@ -0,0 +1,66 @@
+#include "ScratchArena.h"
+
+//rounds a number of floats up so the next channel starts aligned
+static size_t roundUpToAlignment(size_t numFloats)
+{
+    return (numFloats + ScratchArena::alignment - 1) & ~(size_t) (ScratchArena::alignment - 1);
+}
+
+ScratchArena::ScratchArena()
+{
+}
+
+ScratchArena::~ScratchArena()
+{
+}
+
+void ScratchArena::prepare(int numChannels, int maxSamples, int numViews)
+{
+    auto needed = roundUpToAlignment((size_t) maxSamples) * (size_t) numChannels * (size_t) numViews;
+
+    if (needed != capacity)
+    {
+        //the extra alignment lets the base pointer be moved up to the first aligned address
+        memory.allocate(needed + alignment, true);
+
+        auto address = reinterpret_cast<juce::pointer_sized_uint>(memory.get());
+        auto aligned = (address + alignment * sizeof(float) - 1) & ~(juce::pointer_sized_uint) (alignment * sizeof(float) - 1);
+
+        base        = reinterpret_cast<float*>(aligned);
+        capacity    = needed;
+    }
+
+    used = 0;
+}
+
+void ScratchArena::release()
+{
+    memory.free();
+    base        = nullptr;
+    capacity    = 0;
+    used        = 0;
+}
+
+juce::AudioBuffer<float> ScratchArena::getBuffer(int numChannels, int numSamples) noexcept
+{
+    //an AudioBuffer that refers to external data keeps up to 32 channel pointers without allocating
+    const int maxChannels = 32;
+
+    auto channelSize = roundUpToAlignment((size_t) numSamples);
+
+    if (numChannels <= 0 || numChannels > maxChannels || used + channelSize * (size_t) numChannels > capacity)
+    {
+        jassertfalse;
+        return {};
+    }
+
+    float* channels[maxChannels];
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        channels[channel] = base + used;
+        used += channelSize;
+    }
+
+    return juce::AudioBuffer<float>(channels, numChannels, numSamples);
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+/*one block of memory per plugin instance that every stage takes its temporary buffers from
+
+it's allocated once in prepareToPlay, big enough for a fixed number of channels x max block size views,
+processBlock then hands out views into it by bumping an offset and starts again from the top on the
+next block, so nothing on the audio thread ever allocates and all the scratch data sits next to each other*/
+class ScratchArena
+{
+public:
+    ScratchArena();
+    ~ScratchArena();
+
+    //room for numViews buffers of numChannels x maxSamples each, message thread only
+    void prepare(int numChannels, int maxSamples, int numViews);
+    void release();
+
+    //starts handing out from the top again, every view given out before is invalid after this
+    void reset() noexcept { used = 0; }
+
+    //a buffer that refers to arena memory, every channel aligned for simd
+    //comes back with no channels if the arena is out of room, which means prepare asked for too few views
+    juce::AudioBuffer<float> getBuffer(int numChannels, int numSamples) noexcept;
+
+    size_t getSizeInBytes() const noexcept { return capacity * sizeof(float); }
+
+    //channels start on 64 byte boundaries, wide enough for every simd width we compile for
+    static const int alignment = 16;
+
+private:
+    juce::HeapBlock<float> memory;
+    float* base     = nullptr;
+    size_t capacity = 0;
+    size_t used     = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ScratchArena)
+};
@@ -0,0 +1,36 @@
+#pragma once
+
+/*the single sample curves ShapingFunctions and the DspKernels share, nothing else goes in here
+
+DspKernelsBody.h includes this inside an anonymous namespace so every kernel unit builds its own copy at its own width,
+so it has to stay inline functions only, anything declared here and defined elsewhere would go missing there*/
+#include <algorithm>
+#include <cmath>
+
+namespace ShapingFunctions
+{
+    //folds any x into [-1, 1] without changing sin(x * pi / 2), the curve has a period of 4 and mirrors around 1 and -1
+    inline float foldHalfPi(float x) noexcept
+    {
+        auto r = x - 4.0f * std::floor(x * 0.25f + 0.5f);
+        return std::max(-2.0f - r, std::min(r, 2.0f - r));
+    }
+
+    //minimax over [-1, 1], odd so only the odd powers
+    inline float sinHalfPiPolynomial(float r) noexcept
+    {
+        auto r2 = r * r;
+        return r * (1.57079101f + r2 * (-0.645892849f + r2 * (0.079434344f + r2 * -0.00433309481f)));
+    }
+
+    //[7/6] pade, clamped where it comes closest to the real curve, past that it overshoots
+    inline float tanhPade(float x) noexcept
+    {
+        x = std::max(-4.8f, std::min(4.8f, x));
+
+        auto x2 = x * x;
+        auto a  = x * (135135.0f + x2 * (17325.0f + x2 * (378.0f + x2)));
+        auto b  = 135135.0f + x2 * (62370.0f + x2 * (3150.0f + x2 * 28.0f));
+        return std::max(-1.0f, std::min(1.0f, a / b));
+    }
+}
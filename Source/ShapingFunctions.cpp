@@ -0,0 +1,214 @@
+#include "ShapingFunctions.h"
+#include "DspKernels.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace ShapingFunctions
+{
+    //sin(r * pi / 2) over r in [-1, 1] and tanh over [-tanhRange, tanhRange], one extra point for the interpolation
+    const int sinTableSize      = 512;
+    const int tanhTableSize     = 2048;
+    const float tanhRange       = 8.0f;
+
+    //the second antiderivative of tanh over [0, logCoshRange], past that log(cosh(x)) is |x| - log(2) to within 1e-7
+    const int logCoshTableSize  = 512;
+    const double logCoshRange   = 8.0;
+    const double log2           = 0.69314718055994531;
+
+    struct Tables
+    {
+        Tables()
+        {
+            for (int i = 0; i <= sinTableSize; ++i)
+                sin[(size_t) i] = (float) std::sin((-1.0 + 2.0 * i / sinTableSize) * 1.5707963267948966);
+
+            for (int i = 0; i <= tanhTableSize; ++i)
+                tanh[(size_t) i] = (float) std::tanh(-tanhRange + 2.0 * tanhRange * i / tanhTableSize);
+
+            //log(cosh(x)) has no closed form integral, so it's integrated with simpson's rule between the points
+            const double step = logCoshRange / logCoshTableSize;
+            const int substeps = 16;
+
+            logCoshIntegral[0] = 0.0;
+
+            for (int i = 0; i <= logCoshTableSize; ++i)
+            {
+                logCoshValue[(size_t) i] = ShapingFunctions::logCosh(i * step);
+
+                if (i == logCoshTableSize)
+                    break;
+
+                double sum = 0.0;
+
+                for (int j = 0; j < substeps; ++j)
+                {
+                    auto a = (i + (double) j / substeps) * step;
+                    auto h = step / substeps;
+                    sum += h / 6.0 * (ShapingFunctions::logCosh(a) + 4.0 * ShapingFunctions::logCosh(a + 0.5 * h)
+                                      + ShapingFunctions::logCosh(a + h));
+                }
+
+                logCoshIntegral[(size_t) i + 1] = logCoshIntegral[(size_t) i] + sum;
+            }
+        }
+
+        std::array<float, sinTableSize + 1> sin;
+        std::array<float, tanhTableSize + 1> tanh;
+        std::array<double, logCoshTableSize + 1> logCoshValue;
+        std::array<double, logCoshTableSize + 1> logCoshIntegral;
+    };
+
+    static const Tables& getTables()
+    {
+        static const Tables tables;
+        return tables;
+    }
+
+    void initialise()
+    {
+        getTables();
+    }
+
+    //linear interpolation, position is already scaled to the table and clamped to [0, size]
+    static inline float lookup(const float* table, int size, float position) noexcept
+    {
+        auto index = std::min((int) position, size - 1);
+        auto frac  = position - (float) index;
+        return table[index] + frac * (table[index + 1] - table[index]);
+    }
+
+    float sinHalfPi(float x, Quality quality) noexcept
+    {
+        switch (quality)
+        {
+            case Quality::lookupTable:
+                return lookup(getTables().sin.data(), sinTableSize, (foldHalfPi(x) + 1.0f) * (0.5f * sinTableSize));
+            case Quality::polynomial:
+                return sinHalfPiPolynomial(foldHalfPi(x));
+            case Quality::exact:
+            default:
+                return std::sin(x * 1.57079632679f);
+        }
+    }
+
+    float tanh(float x, Quality quality) noexcept
+    {
+        switch (quality)
+        {
+            case Quality::lookupTable:
+            {
+                auto position = (x + tanhRange) * (0.5f * tanhTableSize / tanhRange);
+                return lookup(getTables().tanh.data(), tanhTableSize, std::max(0.0f, std::min((float) tanhTableSize, position)));
+            }
+            case Quality::polynomial:
+                return tanhPade(x);
+            case Quality::exact:
+            default:
+                return std::tanh(x);
+        }
+    }
+
+    //the quality is picked once per block, each tier gets its own loop
+    void sinHalfPi(float* samples, int numSamples, float drive, Quality quality) noexcept
+    {
+        switch (quality)
+        {
+            case Quality::lookupTable:
+            {
+                auto* table = getTables().sin.data();
+
+                for (int i = 0; i < numSamples; ++i)
+                    samples[i] = lookup(table, sinTableSize, (foldHalfPi(drive * samples[i]) + 1.0f) * (0.5f * sinTableSize));
+                break;
+            }
+            case Quality::polynomial:
+            {
+                DspKernels::get().sinHalfPi(samples, numSamples, drive);
+                break;
+            }
+            case Quality::exact:
+            default:
+            {
+                for (int i = 0; i < numSamples; ++i)
+                    samples[i] = std::sin(drive * samples[i] * 1.57079632679f);
+                break;
+            }
+        }
+    }
+
+    void tanh(float* samples, int numSamples, float drive, Quality quality) noexcept
+    {
+        switch (quality)
+        {
+            case Quality::lookupTable:
+            {
+                auto* table = getTables().tanh.data();
+                const auto scale = 0.5f * tanhTableSize / tanhRange;
+
+                for (int i = 0; i < numSamples; ++i)
+                {
+                    auto position = (drive * samples[i] + tanhRange) * scale;
+                    samples[i] = lookup(table, tanhTableSize, std::max(0.0f, std::min((float) tanhTableSize, position)));
+                }
+                break;
+            }
+            case Quality::polynomial:
+            {
+                DspKernels::get().tanh(samples, numSamples, drive);
+                break;
+            }
+            case Quality::exact:
+            default:
+            {
+                for (int i = 0; i < numSamples; ++i)
+                    samples[i] = std::tanh(drive * samples[i]);
+                break;
+            }
+        }
+    }
+
+    void wrap(float* samples, int numSamples, float drive) noexcept
+    {
+        DspKernels::get().wrap(samples, numSamples, drive);
+    }
+
+    double logCosh(double x) noexcept
+    {
+        //written so cosh never overflows
+        x = std::abs(x);
+        return x + std::log1p(std::exp(-2.0 * x)) - log2;
+    }
+
+    double logCoshIntegral(double x) noexcept
+    {
+        //odd, so only the positive half is stored
+        auto sign = x < 0.0 ? -1.0 : 1.0;
+        x = std::abs(x);
+
+        auto& tables = getTables();
+
+        if (x >= logCoshRange)
+        {
+            auto end = tables.logCoshIntegral[logCoshTableSize];
+            return sign * (end + 0.5 * (x * x - logCoshRange * logCoshRange) - log2 * (x - logCoshRange)
+                           + 0.5 * (std::exp(-2.0 * logCoshRange) - std::exp(-2.0 * x)));
+        }
+
+        //cubic hermite, the slopes are log(cosh(x)) itself so it's far more accurate than the table spacing suggests
+        const double step = logCoshRange / logCoshTableSize;
+        auto position = x / step;
+        auto index = std::min((int) position, logCoshTableSize - 1);
+        auto t = position - index;
+        auto t2 = t * t;
+        auto t3 = t2 * t;
+
+        auto y = (2.0 * t3 - 3.0 * t2 + 1.0) * tables.logCoshIntegral[(size_t) index]
+               + (t3 - 2.0 * t2 + t) * step * tables.logCoshValue[(size_t) index]
+               + (-2.0 * t3 + 3.0 * t2) * tables.logCoshIntegral[(size_t) index + 1]
+               + (t3 - t2) * step * tables.logCoshValue[(size_t) index + 1];
+
+        return sign * y;
+    }
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+/*the curves behind the sin and tanh distortion shapes and the overdrive wrap, with no juce in here
+so they can be built and measured on their own
+
+every curve comes in three tiers, picked per instance with the Shaper Quality parameter
+
+    lookupTable     linear interpolation in a small table, cheapest, the lookups don't vectorise
+    polynomial      a minimax polynomial for sin, a clamped [7/6] pade for tanh, no branches so they vectorise
+    exact           std::sin and std::tanh
+
+max absolute error against the double precision result, measured over [-8, 8] in steps of 1e-5
+
+                    sinHalfPi       tanh
+    lookupTable     4.8e-6          6.2e-6
+    polynomial      7.3e-7          7.2e-5
+    exact           8.3e-7          1.0e-7
+
+exact sin is behind the polynomial out at the edges because x * pi / 2 is rounded to a float first
+
+the drive gets multiplied in first, every function works in place on a block, the polynomial tier and the wrap go
+through DspKernels so they run at the widest vectors the cpu has, the single sample curves are inline in
+ShapingCurves.h so the kernels can build them at their own width*/
+#include "ShapingCurves.h"
+
+namespace ShapingFunctions
+{
+    enum class Quality { lookupTable, polynomial, exact };
+
+    //fills the tables, they're also filled the first time they're used but that shouldn't be on the audio thread
+    void initialise();
+
+    //sin(x * pi / 2) of drive * x, for any x
+    void sinHalfPi(float* samples, int numSamples, float drive, Quality quality) noexcept;
+
+    //tanh of drive * x
+    void tanh(float* samples, int numSamples, float drive, Quality quality) noexcept;
+
+    //drive * x wrapped into [-1, 1), exact in every tier, floor instead of fmod is already fast
+    void wrap(float* samples, int numSamples, float drive) noexcept;
+
+    //single sample versions of the curves for code that can't work a block at a time
+    float sinHalfPi(float x, Quality quality) noexcept;
+    float tanh(float x, Quality quality) noexcept;
+
+    //the first and second antiderivatives of tanh, for the anti-aliased saturation, in double because they get
+    //differenced, the second comes out of a table and is within 1e-9 of the real thing
+    double logCosh(double x) noexcept;
+    double logCoshIntegral(double x) noexcept;
+}
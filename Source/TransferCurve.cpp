@@ -0,0 +1,157 @@
+#include "TransferCurve.h"
+#include "DspKernels.h"
+
+const int TransferCurve::maxPoints;
+const int TransferTable::size;
+
+TransferCurve TransferCurve::createDefault()
+{
+    TransferCurve curve;
+    curve.points = { { -1.0f, -1.0f }, { 0.0f, 0.0f }, { 1.0f, 1.0f } };
+    return curve;
+}
+
+float TransferCurve::evaluate(float x) const
+{
+    auto numPoints = (int) points.size();
+
+    if (numPoints == 0)
+        return juce::jlimit(-1.0f, 1.0f, x);
+
+    if (numPoints == 1 || x <= points.front().x)
+        return points.front().y;
+
+    if (x >= points.back().x)
+        return points.back().y;
+
+    //the segment x is in
+    int k = 0;
+
+    while (k < numPoints - 2 && x > points[(size_t) k + 1].x)
+        ++k;
+
+    auto secant = [this](int i)
+    {
+        auto dx = points[(size_t) i + 1].x - points[(size_t) i].x;
+        return dx > 0.0f ? (points[(size_t) i + 1].y - points[(size_t) i].y) / dx : 0.0f;
+    };
+
+    //fritsch carlson slopes, flat at a peak or a dip so the curve never swings past its points
+    auto tangent = [&secant, numPoints](int i)
+    {
+        if (i == 0)
+            return secant(0);
+
+        if (i == numPoints - 1)
+            return secant(numPoints - 2);
+
+        auto before = secant(i - 1);
+        auto after  = secant(i);
+
+        if (before * after <= 0.0f)
+            return 0.0f;
+
+        //harmonic mean, at most twice the smaller one, which keeps every piece monotone
+        return 2.0f / (1.0f / before + 1.0f / after);
+    };
+
+    auto& p0 = points[(size_t) k];
+    auto& p1 = points[(size_t) k + 1];
+    auto h = p1.x - p0.x;
+
+    if (h <= 0.0f)
+        return p1.y;
+
+    auto t  = (x - p0.x) / h;
+    auto t2 = t * t;
+    auto t3 = t2 * t;
+
+    auto y = (2.0f * t3 - 3.0f * t2 + 1.0f) * p0.y
+           + (t3 - 2.0f * t2 + t) * h * tangent(k)
+           + (-2.0f * t3 + 3.0f * t2) * p1.y
+           + (t3 - t2) * h * tangent(k + 1);
+
+    return juce::jlimit(-1.0f, 1.0f, y);
+}
+
+void TransferCurve::sanitise()
+{
+    for (auto& point : points)
+    {
+        point.x = juce::jlimit(-1.0f, 1.0f, point.x);
+        point.y = juce::jlimit(-1.0f, 1.0f, point.y);
+    }
+
+    std::stable_sort(points.begin(), points.end(), [](juce::Point<float> a, juce::Point<float> b) { return a.x < b.x; });
+
+    if (points.size() > (size_t) maxPoints)
+        points.resize((size_t) maxPoints);
+
+    if (points.size() < 2)
+    {
+        *this = createDefault();
+        return;
+    }
+
+    points.front().x = -1.0f;
+    points.back().x  = 1.0f;
+}
+
+juce::ValueTree TransferCurve::toValueTree(const juce::Identifier& type) const
+{
+    juce::ValueTree tree(type);
+
+    for (auto& point : points)
+    {
+        juce::ValueTree child("POINT");
+        child.setProperty("x", point.x, nullptr);
+        child.setProperty("y", point.y, nullptr);
+        tree.appendChild(child, nullptr);
+    }
+
+    return tree;
+}
+
+TransferCurve TransferCurve::fromValueTree(const juce::ValueTree& tree)
+{
+    TransferCurve curve;
+
+    for (const auto& child : tree)
+    {
+        auto x = (float) child.getProperty("x", 0.0f);
+        auto y = (float) child.getProperty("y", 0.0f);
+
+        if (std::isfinite(x) && std::isfinite(y))
+            curve.points.push_back({ x, y });
+    }
+
+    curve.sanitise();
+    return curve;
+}
+
+//==============================================================================
+TransferTable::TransferTable(const TransferCurve& curve)
+{
+    intercepts.resize((size_t) size + 1);
+    slopes.resize((size_t) size + 1);
+
+    auto previous = curve.evaluate(-1.0f);
+
+    for (int i = 0; i < size; ++i)
+    {
+        auto next = curve.evaluate(-1.0f + 2.0f * (float) (i + 1) / (float) size);
+
+        slopes[(size_t) i]      = next - previous;
+        intercepts[(size_t) i]  = previous - slopes[(size_t) i] * (float) i;
+        previous = next;
+    }
+
+    slopes[(size_t) size]       = slopes[(size_t) size - 1];
+    intercepts[(size_t) size]   = intercepts[(size_t) size - 1];
+}
+
+void TransferTable::process(float* samples, int numSamples, float drive) const noexcept
+{
+    //a scale, a clamp, a convert, two loads and a multiply add per sample, no branches
+    DspKernels::get().lineTable(samples, numSamples, drive, intercepts.data(), slopes.data(), size);
+}
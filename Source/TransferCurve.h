@@ -0,0 +1,47 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+/*the user drawn curve behind the Custom distortion type
+
+the editor works on a TransferCurve, a handful of points joined by a monotone cubic spline so it never overshoots
+between them, the processor compiles that into a TransferTable on the message thread and hands it to the audio thread,
+which only ever looks things up in the table*/
+struct TransferCurve
+{
+    //sorted by x, the first point is always at x = -1 and the last at x = 1, every y is inside [-1, 1]
+    std::vector<juce::Point<float>> points;
+
+    //a straight line from (-1, -1) to (1, 1), what Custom sounds like before anything gets drawn
+    static TransferCurve createDefault();
+
+    //the spline at x, x outside [-1, 1] holds the end values
+    float evaluate(float x) const;
+
+    //sorts the points, pulls them into the box, pins the ends and drops any past maxPoints
+    void sanitise();
+
+    juce::ValueTree toValueTree(const juce::Identifier& type) const;
+    static TransferCurve fromValueTree(const juce::ValueTree& tree);
+
+    static const int maxPoints = 16;
+};
+
+//a TransferCurve sampled over [-1, 1], inputs past that hold the end values
+class TransferTable
+{
+public:
+    explicit TransferTable(const TransferCurve& curve);
+
+    //drive * x through the curve, in place
+    void process(float* samples, int numSamples, float drive) const noexcept;
+
+    static const int size = 4096;
+
+private:
+    //one line per segment in terms of the table position, y = intercept + slope * position,
+    //plus a copy of the last one so the position at the very end doesn't need its own check
+    std::vector<float> intercepts, slopes;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TransferTable)
+};
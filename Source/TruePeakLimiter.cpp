@@ -0,0 +1,217 @@
+#include "TruePeakLimiter.h"
+#include "DspKernels.h"
+
+namespace
+{
+    //how far ahead the limiter looks and how fast it lets go
+    const double lookaheadSeconds = 0.0015;
+    const double releaseSeconds   = 0.1;
+
+    //how long switching it on or off crossfades for
+    const double switchSeconds    = 0.005;
+}
+
+constexpr float TruePeakLimiter::safetyMarginDb;
+
+TruePeakLimiter::TruePeakLimiter()
+{
+    //a blackman windowed sinc at a quarter, a half and three quarters past the sample, every point normalised to
+    //unity at dc
+    for (int k = 0; k < numPoints; ++k)
+    {
+        auto fraction = (k + 1) / (double) (numPoints + 1);
+        auto* taps = coefficients + k * numTaps;
+        double sum = 0.0;
+
+        for (int j = 0; j < numTaps; ++j)
+        {
+            auto x = (halfLength - 1 + fraction) - j;
+            auto px = juce::MathConstants<double>::pi * x;
+            auto window = 0.42 + 0.5 * std::cos(px / halfLength) + 0.08 * std::cos(2.0 * px / halfLength);
+
+            taps[j] = (float) (std::sin(px) / px * window);
+            sum += taps[j];
+        }
+
+        for (int j = 0; j < numTaps; ++j)
+            taps[j] = (float) (taps[j] / sum);
+    }
+}
+
+void TruePeakLimiter::prepare(double sampleRate, int newMaxBlockSize, int newNumChannels)
+{
+    numChannels  = juce::jmax(1, newNumChannels);
+    maxBlockSize = juce::jmax(1, newMaxBlockSize);
+    lookahead    = juce::jmax(1, juce::roundToInt(sampleRate * lookaheadSeconds));
+
+    //the interpolator puts the peaks halfLength behind the input, the moving average needs all of the lookahead
+    //in front of the sample it's applied to
+    latency = halfLength + lookahead - 1;
+    inverseLookahead = 1.0 / lookahead;
+
+    lineLength = numTaps - 1 + maxBlockSize;
+    lines.assign((size_t) (numChannels * lineLength), 0.0f);
+    intervalPeaks.assign((size_t) (numChannels * maxBlockSize), 0.0f);
+    lastIntervalPeaks.assign((size_t) numChannels, 0.0f);
+    delays.assign((size_t) (numChannels * latency), 0.0f);
+
+    dequePeaks.assign((size_t) lookahead, 0.0f);
+    dequeFrames.assign((size_t) lookahead, 0);
+    gains.assign((size_t) lookahead, 1.0f);
+
+    releaseCoefficient = (float) (1.0 - std::exp(-1.0 / (releaseSeconds * sampleRate)));
+    amount.reset(sampleRate, switchSeconds);
+
+    reset();
+}
+
+void TruePeakLimiter::reset()
+{
+    std::fill(lines.begin(), lines.end(), 0.0f);
+    std::fill(lastIntervalPeaks.begin(), lastIntervalPeaks.end(), 0.0f);
+    std::fill(delays.begin(), delays.end(), 0.0f);
+    std::fill(gains.begin(), gains.end(), 1.0f);
+
+    delayPosition = gainPosition = 0;
+    dequeFront = dequeSize = 0;
+    frame = 0;
+
+    gainSum = (double) lookahead;
+    lastReleasedGain = 1.0f;
+
+    amount.setCurrentAndTargetValue(enabled ? 1.0f : 0.0f);
+}
+
+void TruePeakLimiter::setCeiling(float newCeilingDb) noexcept
+{
+    if (newCeilingDb != ceilingDb)
+    {
+        ceilingDb = newCeilingDb;
+        ceiling = juce::Decibels::decibelsToGain(newCeilingDb - safetyMarginDb);
+    }
+}
+
+void TruePeakLimiter::setEnabled(bool shouldBeEnabled) noexcept
+{
+    if (shouldBeEnabled != enabled)
+    {
+        enabled = shouldBeEnabled;
+        amount.setTargetValue(enabled ? 1.0f : 0.0f);
+    }
+}
+
+void TruePeakLimiter::process(juce::AudioBuffer<float>& buffer) noexcept
+{
+    auto channelsToDo = juce::jmin(numChannels, buffer.getNumChannels());
+    auto* data = buffer.getArrayOfWritePointers();
+
+    for (int start = 0; start < buffer.getNumSamples(); start += maxBlockSize)
+        processBlock(data, channelsToDo, start, juce::jmin(maxBlockSize, buffer.getNumSamples() - start));
+}
+
+void TruePeakLimiter::processBlock(float* const* data, int channelsToDo, int start, int numSamples) noexcept
+{
+    auto& kernels = DspKernels::get();
+
+    for (int channel = 0; channel < channelsToDo; ++channel)
+    {
+        auto* line = lines.data() + channel * lineLength;
+
+        std::copy(data[channel] + start, data[channel] + start + numSamples, line + numTaps - 1);
+        kernels.intervalPeaks(line, numSamples, coefficients, numTaps, intervalPeaks.data() + channel * maxBlockSize);
+
+        //the end of this block is the history of the next
+        std::copy(line + numSamples, line + numSamples + numTaps - 1, line);
+    }
+
+    //the state lives in locals for the block, stores into the float buffers could otherwise be the float members
+    //as far as the compiler knows, and it would reload them all for every sample
+    auto* peaks = intervalPeaks.data();
+    auto* lastPeaks = lastIntervalPeaks.data();
+    auto* queuedPeaks = dequePeaks.data();
+    auto* queuedFrames = dequeFrames.data();
+    auto* released = gains.data();
+    auto* delayed = delays.data();
+
+    auto front = dequeFront, size = dequeSize;
+    auto gainIndex = gainPosition, delayIndex = delayPosition;
+    auto releasedGain = lastReleasedGain;
+    auto sum = gainSum;
+    const auto limit = ceiling, release = releaseCoefficient;
+
+    //the on and off crossfade, ramped across the block
+    const auto startAmount = amount.getCurrentValue();
+    const auto amountStep = (amount.skip(numSamples) - startAmount) / (float) numSamples;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        //a sample's peak is the louder of the intervals before and after it
+        auto peak = 0.0f;
+
+        for (int channel = 0; channel < channelsToDo; ++channel)
+        {
+            auto interval = peaks[channel * maxBlockSize + i];
+            peak = juce::jmax(peak, interval, lastPeaks[channel]);
+            lastPeaks[channel] = interval;
+        }
+
+        //whatever left the lookahead is gone, whatever is quieter than the new peak can never be the max again
+        if (size > 0 && queuedFrames[front] <= frame - lookahead)
+        {
+            if (++front == lookahead)
+                front = 0;
+
+            --size;
+        }
+
+        auto back = front + size;
+
+        while (size > 0 && queuedPeaks[(back > lookahead ? back - lookahead : back) - 1] <= peak)
+        {
+            --size;
+            --back;
+        }
+
+        if (back >= lookahead)
+            back -= lookahead;
+
+        queuedPeaks[back] = peak;
+        queuedFrames[back] = frame++;
+        ++size;
+
+        auto held = queuedPeaks[front];
+        auto target = held > limit ? limit / held : 1.0f;
+
+        //straight down, back up over the release, it never ends up above the target so the average can't either
+        releasedGain = target < releasedGain ? target : releasedGain + release * (target - releasedGain);
+
+        sum += releasedGain - released[gainIndex];
+        released[gainIndex] = releasedGain;
+
+        if (++gainIndex == lookahead)
+            gainIndex = 0;
+
+        auto gain = (float) (sum * inverseLookahead);
+        auto wet = startAmount + amountStep * (float) (i + 1);
+
+        for (int channel = 0; channel < channelsToDo; ++channel)
+        {
+            auto& sample = data[channel][start + i];
+            auto& slot = delayed[channel * latency + delayIndex];
+            auto input = sample;
+
+            sample = input + wet * (slot * gain - input);
+            slot = input;
+        }
+
+        if (++delayIndex == latency)
+            delayIndex = 0;
+    }
+
+    dequeFront = front;
+    dequeSize = size;
+    gainPosition = gainIndex;
+    delayPosition = delayIndex;
+    lastReleasedGain = releasedGain;
+    gainSum = sum;
+}
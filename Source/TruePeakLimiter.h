@@ -0,0 +1,97 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+/*a lookahead limiter for the very end of the chain that keeps the true peak under a ceiling, the peaks between the
+samples a dac or a lossy encoder reconstructs included, not just the samples themselves
+
+every sample gets interpolated at 4x with a short windowed sinc, DspKernels::intervalPeaks works out the three
+points between it and the next one for the whole block at once, the loudest of the sample and the points on either
+side of it is its peak, linked across the channels
+
+the running max of the peaks over the lookahead comes out of a monotonic deque, every peak goes in and out of it at
+most once so it's O(1) per sample however long the lookahead is, the gain that max asks for gets a release and then
+a moving average over the same lookahead, which ramps it down before the peak instead of on it
+
+the 4x points can still miss the top of a harsh transient that falls between them, by up to about 0.6 dB, so the
+gain aims that far under the ceiling
+
+turned off it keeps running, detector and delay included, and crossfades over to the input as it comes in, so
+switching it either way never starts from an empty delay line or jumps from delayed to undelayed audio
+
+the output is exactly getLatencyInSamples() late while it's on*/
+class TruePeakLimiter
+{
+public:
+    TruePeakLimiter();
+
+    //message thread
+    void prepare(double sampleRate, int maxBlockSize, int numChannels);
+    void reset();
+
+    //audio thread, in dBTP
+    void setCeiling(float newCeilingDb) noexcept;
+
+    //audio thread, off crossfades to the undelayed input over a few ms, on crossfades back
+    void setEnabled(bool shouldBeEnabled) noexcept;
+
+    int getLatencyInSamples() const noexcept { return latency; }
+
+    //audio thread, limits the first numChannels of the buffer in place, the channels share one gain
+    void process(juce::AudioBuffer<float>& buffer) noexcept;
+
+    static const int halfLength = 8;                //the interpolator's taps on either side of a point
+    static const int numTaps    = 2 * halfLength;
+    static const int numPoints  = 3;                //between every two samples, 4x, what the kernel does
+
+    static constexpr float safetyMarginDb = 0.6f;   //how far under the ceiling the gain aims
+
+private:
+    //one fir per point, tap j of point k is coefficients[k * numTaps + j]
+    float coefficients[numPoints * numTaps] = {};
+
+    int numChannels = 0;
+    int maxBlockSize = 0;
+
+    //per channel, numTaps - 1 samples of history then the block
+    std::vector<float> lines;
+    int lineLength = 0;
+
+    //per channel, the loudest of every sample of the block and the points after it, and of the last block's last
+    std::vector<float> intervalPeaks;
+    std::vector<float> lastIntervalPeaks;
+
+    //per channel, the audio waiting for its gain
+    std::vector<float> delays;
+    int delayPosition = 0;
+
+    //the monotonic deque of the peaks in the lookahead, a ring of lookahead slots, decreasing from the front
+    std::vector<float> dequePeaks;
+    std::vector<juce::int64> dequeFrames;
+    int dequeFront = 0, dequeSize = 0;
+    juce::int64 frame = 0;
+
+    //the released gain over the lookahead for the moving average, the sum is a double so adding one float and
+    //taking another out never drifts
+    std::vector<float> gains;
+    int gainPosition = 0;
+    double gainSum = 0.0;
+    float lastReleasedGain = 1.0f;
+    float releaseCoefficient = 0.0f;
+
+    int lookahead = 1;
+    double inverseLookahead = 1.0;
+    int latency = 0;
+
+    float ceilingDb = 0.0f;
+    float ceiling = 1.0f;
+
+    //how much of the limited output comes out, 0 is the input as it came in
+    bool enabled = true;
+    juce::SmoothedValue<float> amount;
+
+    //at most maxBlockSize samples from start on
+    void processBlock(float* const* data, int channelsToDo, int start, int numSamples) noexcept;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TruePeakLimiter)
+};